@@ -1,78 +1,427 @@
-#include <memocache.hpp>
+#include <memo_cache.hpp>
 
-#include <map>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <random>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
-// NOTE: The test is run using the 'int' input space, and a normal distribution to
-//        produce values with a mean of 0 and a variance as defined here:
-constexpr auto INPUT_VARIANCE = 100;
-
-#define MemoCacheBench_impl(s) \
-  static void MemoCache##s(benchmark::State& state) { \
-    mc::memo_cache<int, int, s> c; \
-    \
-    std::random_device device{}; \
-    std::mt19937 generator{device()}; \
-    std::normal_distribution<> distribution{0, INPUT_VARIANCE}; \
-    \
-    for (auto _ : state) { \
-      auto v = c.find_or_insert_with(static_cast<int>(distribution(generator)), \
-                                     [](const auto& k) { return k; }); \
-      benchmark::DoNotOptimize(v); \
-    } \
-  } \
-  BENCHMARK(MemoCache##s);
-
-MemoCacheBench_impl(4)
-MemoCacheBench_impl(8)
-MemoCacheBench_impl(16)
-MemoCacheBench_impl(32)
-MemoCacheBench_impl(64)
-MemoCacheBench_impl(128)
-MemoCacheBench_impl(256)
-// NOTE: Behavior gets worse beyond this size.
-
-// NOTE1: Yes. The test is slightly flawed as it also tests the random key generation
-//        itself. However, I think relatively and statistically speaking it's fine.
-//        The best solution would be to pre-generate a large set of random numbers
-//        and use that set for all of the tests.
-// NOTE2: The test is run using the 'int' input space, and a normal distribution to
-//        produce values with a mean of 0 and a variance as defined here:
-constexpr auto INPUT_VARIANCE = 100;
-
-static void OrderedMap(benchmark::State& state) {
-  std::map<int, int> c;
-
-  std::random_device         device{};
-  std::mt19937               generator{device()};
-  std::normal_distribution<> distribution{0, INPUT_VARIANCE};
+// Benchmark suite of the caches against standard library baselines.
+//
+// Every benchmark replays a pre-generated trace of keys (so that the timing does not include key generation), one
+// lookup per iteration: a hit, or a miss followed by an insert. The time per iteration is the time per operation, and
+// the `hit_rate` counter reports the fraction of hits. Multi-threaded benchmarks replay the trace from a different
+// offset in every thread, on a single shared cache.
+//
+// Build (with Google Benchmark installed):
+//
+//   clang++-18 -std=c++20 -O3 -DNDEBUG -I../include ../benches/memo_cache.cpp -o memo_cache_bench -lbenchmark -pthread
 
-  for (auto _ : state) {
-    const auto x = static_cast<int>(distribution(generator));
-    if (const auto v = c.find(x); v != c.cend()) {
-      benchmark::DoNotOptimize(v);
-    } else {
-      c[x] = x;
+namespace {
+
+constexpr std::size_t SIZE         = 64;         // The capacity of all bounded caches.
+constexpr std::size_t UNIVERSE     = 16 * SIZE;  // The number of distinct keys in the (Zipf and uniform) working set.
+constexpr std::size_t TRACE_LENGTH = 1u << 18;   // The number of lookups in a trace, before it wraps around.
+
+constexpr std::size_t SCAN_PERIOD = 4096;        // Accesses between scans of one-time keys.
+constexpr std::size_t SCAN_LENGTH = 2 * SIZE;    // The number of keys per scan.
+constexpr std::size_t SHIFT_PHASE = TRACE_LENGTH / 8; // Accesses between shifts of the working set.
+constexpr std::size_t MAX_BURST   = 8;           // The longest run of accesses to the same key.
+
+using value_t = std::uint64_t;
+
+/// A 32 byte POD key, e.g. a composite identifier.
+struct pod_key {
+  std::array<std::uint64_t, 4> words;
+
+  bool operator==(const pod_key&) const = default;
+};
+
+} // namespace
+
+template<>
+struct std::hash<pod_key> {
+  std::size_t operator()(const pod_key& k) const noexcept {
+    std::uint64_t h = 0;
+    for (const auto w : k.words) {
+      h = (h ^ w) * 0x100000001B3;
     }
+    return static_cast<std::size_t>(h);
+  }
+};
+
+namespace {
+
+/// The key distributions of the traces.
+enum class distribution {
+  uniform, // Uniform over the working set.
+  zipf,    // Zipf (s = 1) over the working set.
+  scan,    // Zipf, interrupted by sequential scans over keys that are never used again.
+  shift,   // Zipf, over a working set that periodically shifts to (half) new keys.
+  bursty,  // Zipf, with every key repeated in a run of one to `MAX_BURST` accesses.
+};
+
+constexpr std::array DISTRIBUTIONS = {distribution::uniform, distribution::zipf, distribution::scan, distribution::shift, distribution::bursty};
+
+constexpr const char* name_of(distribution d) {
+  switch (d) {
+    case distribution::uniform: return "uniform";
+    case distribution::zipf:    return "zipf";
+    case distribution::scan:    return "scan";
+    case distribution::shift:   return "shift";
+    case distribution::bursty:  return "bursty";
   }
+  return "";
 }
-BENCHMARK(OrderedMap);
 
-static void UnorderedMap(benchmark::State& state) {
-  std::unordered_map<int, int> c;
+/// Draws ranks in `[0, n)` with a Zipf distribution (rank 0 being the most frequent), by inverting the CDF.
+class zipf_distribution {
+  std::vector<double> cdf;
 
-  std::random_device device{};
-  std::mt19937 generator{device()};
-  std::normal_distribution<> distribution{0, INPUT_VARIANCE};
+public:
+  explicit zipf_distribution(std::size_t n, double s = 1.0) : cdf(n) {
+    double sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+      cdf[i] = sum;
+    }
+    for (auto& c : cdf) {
+      c /= sum;
+    }
+  }
 
-  for (auto _ : state) {
-    const auto x = static_cast<int>(distribution(generator));
-    if (const auto v = c.find(x); v != c.cend()) {
-      benchmark::DoNotOptimize(v);
-    } else {
-      c[x] = x;
+  template<typename Generator>
+  std::size_t operator()(Generator& generator) const {
+    const auto u = std::uniform_real_distribution<>{}(generator);
+    return std::min(static_cast<std::size_t>(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin()), cdf.size() - 1);
+  }
+};
+
+/// Generates the key identifiers of a trace (deterministically).
+std::vector<std::uint32_t> make_ids(distribution d) {
+  std::mt19937_64 generator{42};
+
+  const zipf_distribution zipf{UNIVERSE};
+  std::uniform_int_distribution<std::size_t> uniform{0, UNIVERSE - 1};
+
+  std::vector<std::uint32_t> ids;
+  ids.reserve(TRACE_LENGTH);
+
+  std::size_t next_scan_id = UNIVERSE;
+
+  while (ids.size() < TRACE_LENGTH) {
+    switch (d) {
+      case distribution::uniform:
+        ids.push_back(static_cast<std::uint32_t>(uniform(generator)));
+        break;
+      case distribution::zipf:
+        ids.push_back(static_cast<std::uint32_t>(zipf(generator)));
+        break;
+      case distribution::scan:
+        if (!ids.empty() && ids.size() % SCAN_PERIOD == 0) {
+          for (std::size_t i = 0; i < SCAN_LENGTH && ids.size() < TRACE_LENGTH; ++i) {
+            ids.push_back(static_cast<std::uint32_t>(next_scan_id++));
+          }
+        }
+        ids.push_back(static_cast<std::uint32_t>(zipf(generator)));
+        break;
+      case distribution::shift:
+        ids.push_back(static_cast<std::uint32_t>(zipf(generator) + (ids.size() / SHIFT_PHASE) * (UNIVERSE / 2)));
+        break;
+      case distribution::bursty:
+        ids.insert(ids.end(), std::uniform_int_distribution<std::size_t>{1, MAX_BURST}(generator), static_cast<std::uint32_t>(zipf(generator)));
+        break;
+    }
+  }
+
+  ids.resize(TRACE_LENGTH);
+
+  return ids;
+}
+
+template<typename Key>
+Key make_key(std::uint32_t id);
+
+template<>
+int make_key<int>(std::uint32_t id) {
+  return static_cast<int>(id);
+}
+
+template<>
+std::string make_key<std::string>(std::uint32_t id) {
+  // Long enough not to fit in the small string buffer.
+  auto digits = std::to_string(id);
+  return "session/" + std::string(10 - digits.size(), '0') + digits;
+}
+
+template<>
+pod_key make_key<pod_key>(std::uint32_t id) {
+  return {{0xC0FFEE, id, std::uint64_t{id} * 0x9E3779B97F4A7C15, ~std::uint64_t{id}}};
+}
+
+template<typename Key>
+constexpr const char* KEY_NAME = "";
+
+template<>
+constexpr const char* KEY_NAME<int> = "int";
+
+template<>
+constexpr const char* KEY_NAME<std::string> = "string";
+
+template<>
+constexpr const char* KEY_NAME<pod_key> = "pod32";
+
+/// Returns the (pre-generated) trace of keys for distribution `d`.
+template<typename Key>
+const std::vector<Key>& trace(distribution d) {
+  static const auto traces = [] {
+    std::array<std::vector<Key>, DISTRIBUTIONS.size()> result;
+    for (const auto dist : DISTRIBUTIONS) {
+      for (const auto id : make_ids(dist)) {
+        result[static_cast<std::size_t>(dist)].push_back(make_key<Key>(id));
+      }
+    }
+    return result;
+  }();
+
+  return traces[static_cast<std::size_t>(d)];
+}
+
+template<typename Key>
+value_t value_for(const Key& key) {
+  return static_cast<value_t>(std::hash<Key>{}(key));
+}
+
+/// Baseline: an unbounded `std::unordered_map` (i.e. the hit rate of an infinite cache).
+template<typename Key, typename Val>
+class unordered_map_cache {
+  std::unordered_map<Key, Val> map;
+
+public:
+  const Val* find(const Key& key) const {
+    const auto it = map.find(key);
+    return (it != map.end()) ? &it->second : nullptr;
+  }
+
+  void insert(const Key& key, const Val& val) {
+    map.insert_or_assign(key, val);
+  }
+};
+
+/// Baseline: a bounded LRU cache of a `std::list` indexed by a `std::unordered_map`.
+template<typename Key, typename Val, std::size_t Size>
+class lru_cache {
+  std::list<std::pair<Key, Val>> entries; // Most recently used first.
+  std::unordered_map<Key, typename std::list<std::pair<Key, Val>>::iterator> index;
+
+public:
+  const Val* find(const Key& key) {
+    const auto it = index.find(key);
+    if (it == index.end()) {
+      return nullptr;
     }
+
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->second;
   }
+
+  void insert(const Key& key, const Val& val) {
+    if (const auto it = index.find(key); it != index.end()) {
+      it->second->second = val;
+      entries.splice(entries.begin(), entries, it->second);
+      return;
+    }
+
+    if (entries.size() == Size) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+
+    entries.emplace_front(key, val);
+    index.emplace(key, entries.begin());
+  }
+};
+
+/// Baseline for multi-threaded benchmarks: a cache guarded by a single mutex.
+template<typename Cache, typename Key, typename Val>
+class locked {
+  std::mutex mutex;
+  Cache      cache;
+
+public:
+  std::optional<Val> find(const Key& key) {
+    std::scoped_lock lock{mutex};
+    if (const auto v = cache.find(key)) {
+      return *v;
+    }
+    return std::nullopt;
+  }
+
+  void insert(const Key& key, const Val& val) {
+    std::scoped_lock lock{mutex};
+    cache.insert(key, val);
+  }
+};
+
+template<typename Cache>
+std::unique_ptr<Cache> make_cache() {
+  std::unique_ptr<Cache> cache;
+
+  if constexpr (std::is_constructible_v<Cache, std::size_t>) {
+    cache = std::make_unique<Cache>(SIZE);
+  } else {
+    cache = std::make_unique<Cache>();
+  }
+
+  if constexpr (requires { cache->set_time_to_live(std::chrono::hours{1}); }) {
+    cache->set_time_to_live(std::chrono::hours{1});
+  }
+
+  return cache;
+}
+
+/// Look up `key`, inserting its value on a miss. Returns `true` on a hit.
+template<typename Cache, typename Key>
+bool access(Cache& cache, const Key& key) {
+  if (const auto v = cache.find(key)) {
+    benchmark::DoNotOptimize(v);
+    return true;
+  }
+
+  cache.insert(key, value_for(key));
+  return false;
+}
+
+/// NOTE: The cache is only dereferenced inside the benchmark loop, where all threads have synchronized.
+template<typename Cache, typename Key>
+void replay(benchmark::State& state, distribution d, const std::unique_ptr<Cache>& cache) {
+  const auto& keys = trace<Key>(d);
+
+  auto i = (static_cast<std::size_t>(state.thread_index()) * keys.size()) / static_cast<std::size_t>(state.threads());
+  std::int64_t hits = 0;
+
+  for (auto _ : state) {
+    hits += access(*cache, keys[i]);
+    i = (i + 1 == keys.size()) ? 0 : i + 1;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["hit_rate"] = benchmark::Counter(static_cast<double>(hits) / static_cast<double>(state.iterations()),
+                                                  benchmark::Counter::kAvgThreads);
+}
+
+template<typename Cache, typename Key>
+void register_single(const std::string& name) {
+  for (const auto d : DISTRIBUTIONS) {
+    benchmark::RegisterBenchmark((name + "/" + KEY_NAME<Key> + "/" + name_of(d)).c_str(), [d](benchmark::State& state) {
+      trace<Key>(d); // Generate the trace outside of the timing.
+
+      const auto cache = make_cache<Cache>();
+      replay<Cache, Key>(state, d, cache);
+    });
+  }
+}
+
+template<typename Cache, typename Key>
+void register_multi(const std::string& name) {
+  for (const auto d : DISTRIBUTIONS) {
+    benchmark::RegisterBenchmark((name + "/" + KEY_NAME<Key> + "/" + name_of(d)).c_str(), [d](benchmark::State& state) {
+      static std::unique_ptr<Cache> cache;
+
+      // NOTE: All threads wait for each other at the start and end of the benchmark loop.
+      if (state.thread_index() == 0) {
+        trace<Key>(d);
+        cache = make_cache<Cache>();
+      }
+
+      replay<Cache, Key>(state, d, cache);
+
+      if (state.thread_index() == 0) {
+        cache.reset();
+      }
+    })
+      ->Threads(1)
+      ->Threads(2)
+      ->Threads(4)
+      ->Threads(8)
+      ->UseRealTime();
+  }
+}
+
+template<typename Key>
+void register_all() {
+  using V = value_t;
+
+  // Baselines.
+  register_single<unordered_map_cache<Key, V>, Key>("unordered_map");
+  register_single<lru_cache<Key, V, SIZE>, Key>("list_lru");
+
+  // Eviction policies.
+  register_single<mc::memo_cache<Key, V, SIZE>, Key>("memo_cache/fifo");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::policy::clock>, Key>("memo_cache/clock");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::policy::sieve>, Key>("memo_cache/sieve");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::policy::s3fifo>, Key>("memo_cache/s3fifo");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::policy::lru>, Key>("memo_cache/lru");
+
+  // Storage layouts.
+  register_single<mc::memo_cache<Key, V, SIZE, mc::layout::aos>, Key>("memo_cache/aos");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::layout::aligned>, Key>("memo_cache/aligned");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::layout::soa>, Key>("memo_cache/soa");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::layout::fingerprinted<>>, Key>("memo_cache/fingerprinted");
+
+  // Probing order.
+  register_single<mc::memo_cache<Key, V, SIZE, mc::probe::recent>, Key>("memo_cache/recent");
+
+  // Admission.
+  register_single<mc::memo_cache<Key, V, SIZE, mc::admission::tinylfu>, Key>("memo_cache/tinylfu");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::policy::sieve, mc::admission::tinylfu>, Key>("memo_cache/sieve_tinylfu");
+
+  // Expiry and statistics overhead.
+  register_single<mc::memo_cache<Key, V, SIZE, mc::expiry::ttl<>>, Key>("memo_cache/ttl");
+  register_single<mc::memo_cache<Key, V, SIZE, mc::stats::counters>, Key>("memo_cache/stats");
+
+  // Other caches.
+  register_single<mc::indexed_memo_cache<Key, V, SIZE>, Key>("indexed_memo_cache");
+  register_single<mc::dynamic_memo_cache<Key, V>, Key>("dynamic_memo_cache");
+  register_single<mc::concurrent_memo_cache<Key, V, SIZE, 4>, Key>("concurrent_memo_cache");
+  register_single<mc::tiered_memo_cache<Key, V, 16, SIZE, 4>, Key>("tiered_memo_cache");
+  if constexpr (std::is_trivially_copyable_v<Key>) {
+    register_single<mc::seqlock_memo_cache<Key, V, SIZE>, Key>("seqlock_memo_cache");
+  }
+
+  // Multi-threaded.
+  register_multi<locked<unordered_map_cache<Key, V>, Key, V>, Key>("mt/mutex_unordered_map");
+  register_multi<locked<lru_cache<Key, V, SIZE>, Key, V>, Key>("mt/mutex_list_lru");
+  register_multi<locked<mc::memo_cache<Key, V, SIZE>, Key, V>, Key>("mt/mutex_memo_cache");
+  register_multi<mc::concurrent_memo_cache<Key, V, SIZE, 4>, Key>("mt/concurrent_memo_cache");
+  register_multi<mc::concurrent_memo_cache<Key, V, SIZE, 4, mc::lock::shared>, Key>("mt/concurrent_memo_cache/shared");
+  register_multi<mc::tiered_memo_cache<Key, V, 16, SIZE, 4>, Key>("mt/tiered_memo_cache");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  register_all<int>();
+  register_all<std::string>();
+  register_all<pod_key>();
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  return 0;
 }
-BENCHMARK(UnorderedMap);
@@ -20,6 +20,9 @@ struct Process {
   std::unordered_map<int, float> cache1;
   mc::memo_cache<int, float, 32> cache2;
 
+  /// Memoized function, using a `memo_cache` cache internally.
+  decltype(mc::memoize<32>(&some_expensive_calculation)) memoized3 = mc::memoize<32>(&some_expensive_calculation);
+
   /// Regular method, taking the calculation penalty, always.
   float regular(int input) { return some_expensive_calculation(input); }
 
@@ -56,7 +59,8 @@ int main() {
   //
   //   1. a regular (non-memoized) method,
   //   2. a method memoized using a hash map,
-  //   3. a method memoized using a MemoCache cache (two notation variants).
+  //   3. a method memoized using a MemoCache cache (two notation variants),
+  //   4. a function memoized using `mc::memoize`.
   //
   // Each of the methods are fed a series of random input numbers from a
   // normal distribution for which they (fake) "calculate" a result value.
@@ -108,6 +112,12 @@ int main() {
 
   const auto d_memoized2b = clock::now() - start;
 
+  start = clock::now();
+  std::reduce(inputs.cbegin(), inputs.cend(), 0.0f,
+              [&p](float sum, int i) { return sum + p.memoized3(i); });
+
+  const auto d_memoized3 = clock::now() - start;
+
   std::cout << "Done. Timing results:\n";
 
   using Ms = std::chrono::milliseconds;
@@ -115,6 +125,7 @@ int main() {
   std::cout << std::format("Memoized (unordered_map): {} ms\n", std::chrono::duration_cast<Ms>(d_memoized1).count());
   std::cout << std::format("Memoized (memo_cache A):  {} ms\n", std::chrono::duration_cast<Ms>(d_memoized2a).count());
   std::cout << std::format("Memoized (memo_cache B):  {} ms\n", std::chrono::duration_cast<Ms>(d_memoized2b).count());
+  std::cout << std::format("Memoized (memoize):       {} ms\n", std::chrono::duration_cast<Ms>(d_memoized3).count());
 
   const auto get_size = [](std::size_t capacity) { return capacity * (sizeof(int) + sizeof(float)); };
 
@@ -2,47 +2,5029 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
 #include <concepts>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+// The key scan engine uses the widest instruction set enabled at compile time (e.g. `-mavx2`, `-march=native`).
+// Define `MC_DISABLE_SIMD` to force the portable scalar implementation.
+#if !defined(MC_DISABLE_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_SIMD_SSE2
+#include <immintrin.h>
+#if defined(__AVX2__)
+#define MC_SIMD_AVX2
+#endif
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define MC_SIMD_AVX512
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MC_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+// The shared memory cache is available where POSIX shared memory (and robust mutexes) are.
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>) && __has_include(<pthread.h>)
+#define MC_SHARED_MEMORY
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace mc {
 
 inline namespace v1 {
 
+namespace detail {
+
+/// Keys that compare equal exactly when their object representations are equal, and that fit in a single SIMD lane.
+template<typename T>
+concept simd_scannable = (std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>)
+                      && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+/// Lookup keys of another type that can be compared with stored keys, used for heterogeneous lookup.
+template<typename K, typename Key>
+concept lookup_key_for = !std::same_as<K, Key> && requires(const K& k, const Key& key) {
+  { key == k } -> std::convertible_to<bool>;
+};
+
+/// Unsigned integer type of the given width, used as the SIMD lane type for scannable keys.
+template<std::size_t Bytes> struct lane;
+template<> struct lane<1> { using type = std::uint8_t; };
+template<> struct lane<2> { using type = std::uint16_t; };
+template<> struct lane<4> { using type = std::uint32_t; };
+template<> struct lane<8> { using type = std::uint64_t; };
+
+template<std::size_t Bytes>
+using lane_t = typename lane<Bytes>::type;
+
+/// The maximum number of keys compared by a single call to `match_keys` (one bit per key in the resulting mask).
+inline constexpr std::size_t scan_block = 64;
+
+/// Upper bound for the cache size; scannable keys are compared many at a time, so they allow for larger caches.
+template<typename Key>
+inline constexpr std::size_t max_size = simd_scannable<Key> ? 1024 : 128;
+
+#if defined(MC_SIMD_AVX512)
+template<typename U>
+inline std::size_t match_avx512(const unsigned char* data, std::size_t i, std::size_t count, U needle, std::uint64_t& mask) noexcept {
+  constexpr std::size_t LANES = 64 / sizeof(U);
+
+  for (; i + LANES <= count; i += LANES) {
+    const auto v = _mm512_loadu_si512(data + (i * sizeof(U)));
+
+    std::uint64_t m{};
+    if constexpr (sizeof(U) == 1) {
+      m = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(static_cast<char>(needle)));
+    } else if constexpr (sizeof(U) == 2) {
+      m = _mm512_cmpeq_epi16_mask(v, _mm512_set1_epi16(static_cast<short>(needle)));
+    } else if constexpr (sizeof(U) == 4) {
+      m = _mm512_cmpeq_epi32_mask(v, _mm512_set1_epi32(static_cast<int>(needle)));
+    } else {
+      m = _mm512_cmpeq_epi64_mask(v, _mm512_set1_epi64(static_cast<long long>(needle)));
+    }
+
+    mask |= m << i;
+  }
+
+  return i;
+}
+#endif
+
+#if defined(MC_SIMD_AVX2)
+template<typename U>
+inline std::size_t match_avx2(const unsigned char* data, std::size_t i, std::size_t count, U needle, std::uint64_t& mask) noexcept {
+  constexpr std::size_t LANES = 32 / sizeof(U);
+
+  for (; i + LANES <= count; i += LANES) {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + (i * sizeof(U))));
+
+    unsigned m{};
+    if constexpr (sizeof(U) == 1) {
+      m = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(needle)))));
+    } else if constexpr (sizeof(U) == 2) {
+      // Narrow the 16-bit lane results to bytes (per 128-bit half), then gather both halves in the low 128 bits.
+      const auto eq     = _mm256_cmpeq_epi16(v, _mm256_set1_epi16(static_cast<short>(needle)));
+      const auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(eq, _mm256_setzero_si256()), 0b11'01'10'00);
+      m = static_cast<unsigned>(_mm256_movemask_epi8(packed)) & 0xFFFFU;
+    } else if constexpr (sizeof(U) == 4) {
+      const auto eq = _mm256_cmpeq_epi32(v, _mm256_set1_epi32(static_cast<int>(needle)));
+      m = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+    } else {
+      const auto eq = _mm256_cmpeq_epi64(v, _mm256_set1_epi64x(static_cast<long long>(needle)));
+      m = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+    }
+
+    mask |= std::uint64_t{m} << i;
+  }
+
+  return i;
+}
+#endif
+
+#if defined(MC_SIMD_SSE2)
+template<typename U>
+inline std::size_t match_sse2(const unsigned char* data, std::size_t i, std::size_t count, U needle, std::uint64_t& mask) noexcept {
+  constexpr std::size_t LANES = 16 / sizeof(U);
+
+  for (; i + LANES <= count; i += LANES) {
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + (i * sizeof(U))));
+
+    unsigned m{};
+    if constexpr (sizeof(U) == 1) {
+      m = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(needle)))));
+    } else if constexpr (sizeof(U) == 2) {
+      const auto eq = _mm_cmpeq_epi16(v, _mm_set1_epi16(static_cast<short>(needle)));
+      m = static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(eq, _mm_setzero_si128()))) & 0xFFU;
+    } else if constexpr (sizeof(U) == 4) {
+      const auto eq = _mm_cmpeq_epi32(v, _mm_set1_epi32(static_cast<int>(needle)));
+      m = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+    } else {
+      // SSE2 has no 64-bit compare: both 32-bit halves of a lane have to match.
+      const auto eq = _mm_cmpeq_epi32(v, _mm_set1_epi64x(static_cast<long long>(needle)));
+      m = static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1))))));
+    }
+
+    mask |= std::uint64_t{m} << i;
+  }
+
+  return i;
+}
+#endif
+
+#if defined(MC_SIMD_NEON)
+template<typename U>
+inline std::size_t match_neon(const unsigned char* data, std::size_t i, std::size_t count, U needle, std::uint64_t& mask) noexcept {
+  constexpr std::size_t LANES = 16 / sizeof(U);
+
+  // NEON has no movemask; weigh each lane by its bit value and add the lanes horizontally instead.
+  for (; i + LANES <= count; i += LANES) {
+    const auto* p = data + (i * sizeof(U));
+
+    std::uint64_t m{};
+    if constexpr (sizeof(U) == 1) {
+      constexpr std::uint8_t W[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+      const auto bits = vandq_u8(vceqq_u8(vld1q_u8(p), vdupq_n_u8(needle)), vld1q_u8(W));
+      m = std::uint64_t{vaddv_u8(vget_low_u8(bits))} | (std::uint64_t{vaddv_u8(vget_high_u8(bits))} << 8);
+    } else if constexpr (sizeof(U) == 2) {
+      constexpr std::uint16_t W[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+      m = vaddvq_u16(vandq_u16(vceqq_u16(vld1q_u16(reinterpret_cast<const std::uint16_t*>(p)), vdupq_n_u16(needle)), vld1q_u16(W)));
+    } else if constexpr (sizeof(U) == 4) {
+      constexpr std::uint32_t W[4] = {1, 2, 4, 8};
+      m = vaddvq_u32(vandq_u32(vceqq_u32(vld1q_u32(reinterpret_cast<const std::uint32_t*>(p)), vdupq_n_u32(needle)), vld1q_u32(W)));
+    } else {
+      constexpr std::uint64_t W[2] = {1, 2};
+      m = vaddvq_u64(vandq_u64(vceqq_u64(vld1q_u64(reinterpret_cast<const std::uint64_t*>(p)), vdupq_n_u64(needle)), vld1q_u64(W)));
+    }
+
+    mask |= m << i;
+  }
+
+  return i;
+}
+#endif
+
+/// Compare up to `scan_block` keys against `key` at once. Returns a mask with bit `i` set when `keys[i] == key`.
+template<simd_scannable T>
+[[nodiscard]] constexpr std::uint64_t match_keys(const T* keys, std::size_t count, const T& key) noexcept {
+  using U = lane_t<sizeof(T)>;
+
+  count = std::min(count, scan_block); // NOTE: Also tells the optimizer that this is a short loop.
+
+  std::uint64_t mask{};
+
+  // NOTE: Neither the vector instructions nor reinterpreting (pointer) keys as lanes are usable in constant evaluation.
+  if (std::is_constant_evaluated()) {
+    for (std::size_t i = 0; i < count; ++i) {
+      mask |= std::uint64_t{keys[i] == key} << i;
+    }
+
+    return mask;
+  }
+
+  const auto needle = std::bit_cast<U>(key);
+
+  [[maybe_unused]] const auto* data = reinterpret_cast<const unsigned char*>(keys);
+
+  std::size_t i{};
+
+  // Use the widest vectors first, and finish the remainder with narrower ones.
+#if defined(MC_SIMD_AVX512)
+  i = match_avx512<U>(data, i, count, needle, mask);
+#endif
+#if defined(MC_SIMD_AVX2)
+  i = match_avx2<U>(data, i, count, needle, mask);
+#endif
+#if defined(MC_SIMD_SSE2)
+  i = match_sse2<U>(data, i, count, needle, mask);
+#endif
+#if defined(MC_SIMD_NEON)
+  i = match_neon<U>(data, i, count, needle, mask);
+#endif
+
+  // NOTE: The vector loops never go past `count`, but the optimizer may not be able to tell.
+  for (i = std::min(i, count); i < count; ++i) {
+    mask |= std::uint64_t{std::bit_cast<U>(keys[i]) == needle} << i;
+  }
+
+  return mask;
+}
+
+/// Finalize a (possibly weak, e.g. identity) hash value, so that all of its bits depend on all of the input bits.
+[[nodiscard]] constexpr std::uint64_t mix_hash(std::uint64_t h) noexcept {
+  h ^= h >> 33;
+  h *= 0xFF51'AFD7'ED55'8CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CE'B9FE'1A85'EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/// Smallest unsigned integer type that can hold the values `[0, N]`.
+template<std::size_t N>
+using index_t = std::conditional_t<(N <= 0xFF), std::uint8_t,
+                std::conditional_t<(N <= 0xFFFF), std::uint16_t,
+                std::conditional_t<(N <= 0xFFFF'FFFF), std::uint32_t, std::uint64_t>>>;
+
+/// Fixed-size bitmask, stored as 64-bit words so that it can be combined with `match_keys` results directly.
+template<std::size_t Size>
+class bitmask {
+  std::array<std::uint64_t, (Size + 63) / 64> words{};
+
+public:
+  [[nodiscard]] constexpr bool test(std::size_t i) const noexcept {
+    return ((words[i / 64] >> (i % 64)) & 1) != 0;
+  }
+
+  constexpr void set(std::size_t i) noexcept {
+    words[i / 64] |= std::uint64_t{1} << (i % 64);
+  }
+
+  constexpr void reset(std::size_t i) noexcept {
+    words[i / 64] &= ~(std::uint64_t{1} << (i % 64));
+  }
+
+  /// Get the 64 bits starting at bit `base` (which must be a multiple of 64).
+  [[nodiscard]] constexpr std::uint64_t word(std::size_t base) const noexcept {
+    return words[base / 64];
+  }
+
+  [[nodiscard]] constexpr const std::uint64_t* data() const noexcept {
+    return words.data();
+  }
+
+  /// The number of set bits.
+  [[nodiscard]] constexpr std::size_t count() const noexcept {
+    std::size_t n{};
+    for (const auto word : words) {
+      n += static_cast<std::size_t>(std::popcount(word));
+    }
+
+    return n;
+  }
+
+  /// Whether exactly the bits `[0, n)` are set.
+  [[nodiscard]] constexpr bool is_prefix(std::size_t n) const noexcept {
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (test(i) != (i < n)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /// Whether no bits past `Size` are set (e.g. in a mask loaded from a snapshot), as scans use whole words.
+  [[nodiscard]] constexpr bool valid() const noexcept {
+    return (Size % 64 == 0) || (words.back() >> (Size % 64)) == 0;
+  }
+
+  constexpr void clear() noexcept {
+    words = {};
+  }
+
+  bool operator==(const bitmask&) const = default;
+};
+
+/// Returns the index of the first of `count` dense `keys` that is occupied (according to the `occupancy` bitmask words)
+/// and equal to `key`, or `count` if there is none.
+template<typename Key, typename K>
+[[nodiscard]] constexpr std::size_t find_key(const Key* keys, const std::uint64_t* occupancy, std::size_t count, const K& key) {
+  for (std::size_t base = 0; base < count; base += scan_block) {
+    auto mask = occupancy[base / 64];
+
+    // NOTE: Keys of other types are compared using their own `operator==`, which may differ from a bitwise comparison.
+    if constexpr (simd_scannable<Key> && std::same_as<K, Key>) {
+      // NOTE: Unoccupied slots hold stale or value-initialized keys, hence the occupancy mask.
+      mask &= match_keys(keys + base, std::min(scan_block, count - base), key);
+
+      if (mask != 0) {
+        return base + static_cast<std::size_t>(std::countr_zero(mask));
+      }
+    } else {
+      for (; mask != 0; mask &= mask - 1) {
+        if (const auto i = base + static_cast<std::size_t>(std::countr_zero(mask)); keys[i] == key) {
+          return i;
+        }
+      }
+    }
+  }
+
+  return count;
+}
+
+/// Common base of all cache options.
+struct option {};
+
+/// Base of all storage layout options.
+struct layout_option : option {};
+
+/// Base of all eviction policy options.
+struct eviction_option : option {};
+
+/// Base of all lock options.
+struct lock_option : option {};
+
+/// Base of all storage options (of memoized functions).
+struct storage_option : option {};
+
+/// Base of all expiry options.
+struct expiry_option : option {};
+
+/// Base of all statistics options.
+struct stats_option : option {};
+
+/// Base of all admission options.
+struct admission_option : option {};
+
+/// Base of all probing options.
+struct probe_option : option {};
+
+/// Select the option deriving from `Kind` out of `Options`, or `Default` if there is none.
+template<typename Kind, typename Default, typename... Options>
+struct select_option {
+  using type = Default;
+};
+
+template<typename Kind, typename Default, typename Option, typename... Options>
+struct select_option<Kind, Default, Option, Options...> {
+  using type = std::conditional_t<std::derived_from<Option, Kind>, Option, typename select_option<Kind, Default, Options...>::type>;
+};
+
+template<typename Kind, typename Default, typename... Options>
+using select_option_t = typename select_option<Kind, Default, Options...>::type;
+
+/// The number of options deriving from `Kind` out of `Options`.
+template<typename Kind, typename... Options>
+inline constexpr std::size_t option_count = (std::size_t{0} + ... + std::size_t{std::derived_from<Options, Kind>});
+
+/// Every option is a known cache option, and every kind of option is specified at most once.
+template<typename... Options>
+inline constexpr bool valid_options = (std::derived_from<Options, option> && ...) && (option_count<layout_option, Options...> <= 1)
+                                   && (option_count<eviction_option, Options...> <= 1)
+                                   && (option_count<lock_option, Options...> <= 1)
+                                   && (option_count<storage_option, Options...> <= 1)
+                                   && (option_count<expiry_option, Options...> <= 1)
+                                   && (option_count<stats_option, Options...> <= 1)
+                                   && (option_count<admission_option, Options...> <= 1)
+                                   && (option_count<probe_option, Options...> <= 1);
+
+/// Doubly linked list over slot indices `[0, Size)`, ordered from newest (head) to oldest (tail).
+template<std::size_t Size>
+class slot_list {
+  using link_t = index_t<Size>;
+
+  static constexpr link_t NONE = Size;
+
+  std::array<link_t, Size> newer{};
+  std::array<link_t, Size> older{};
+  link_t head = NONE;
+  link_t tail = NONE;
+  std::size_t count{};
+
+public:
+  static constexpr std::size_t none = Size;
+
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return count;
+  }
+
+  /// The tail of the list, or `none`.
+  [[nodiscard]] constexpr std::size_t oldest() const noexcept {
+    return tail;
+  }
+
+  /// The neighbor of `i` towards the head, or `none`.
+  [[nodiscard]] constexpr std::size_t newer_than(std::size_t i) const noexcept {
+    return newer[i];
+  }
+
+  constexpr void push_front(std::size_t i) noexcept {
+    newer[i] = NONE;
+    older[i] = head;
+    (head != NONE ? newer[head] : tail) = static_cast<link_t>(i);
+    head = static_cast<link_t>(i);
+    ++count;
+  }
+
+  constexpr void unlink(std::size_t i) noexcept {
+    (newer[i] != NONE ? older[newer[i]] : head) = older[i];
+    (older[i] != NONE ? newer[older[i]] : tail) = newer[i];
+    --count;
+  }
+
+  constexpr void move_to_front(std::size_t i) noexcept {
+    if (i != head) {
+      unlink(i);
+      push_front(i);
+    }
+  }
+
+  /// Whether the list is well-formed (e.g. when loaded from a snapshot): all links are in range, and the list runs from
+  /// head to tail over `size()` slots. Marks these slots in `members`, failing on any that is marked already.
+  [[nodiscard]] constexpr bool valid(bitmask<Size>& members) const noexcept {
+    const auto in_range = [](link_t link) { return link <= NONE; };
+
+    if (count > Size || head > NONE || tail > NONE || !std::ranges::all_of(newer, in_range) || !std::ranges::all_of(older, in_range)) {
+      return false;
+    }
+
+    std::size_t prev = NONE;
+    std::size_t i    = head;
+
+    for (std::size_t n = 0; n < count; ++n) {
+      if (i == NONE || newer[i] != prev || members.test(i)) {
+        return false;
+      }
+
+      members.set(i);
+      prev = i;
+      i    = older[i];
+    }
+
+    return i == NONE && tail == prev;
+  }
+
+  constexpr void clear() noexcept {
+    head  = NONE;
+    tail  = NONE;
+    count = 0;
+  }
+};
+
+/// Tag for a negative entry: a key known to have no value.
+struct no_value_t {};
+
+/// Uninitialized storage for a `T`, constructed and destroyed explicitly by its owner (which tracks whether it is live).
+/// Trivially copyable if `T` is; otherwise not copyable, as only the owner knows whether there is an object to copy.
+template<typename T>
+union uninitialized {
+  T object;
+
+  constexpr uninitialized() noexcept {}
+  constexpr uninitialized(const uninitialized&)            = default;
+  constexpr uninitialized& operator=(const uninitialized&) = default;
+
+  constexpr ~uninitialized() requires std::is_trivially_destructible_v<T> = default;
+  constexpr ~uninitialized() {}
+};
+
+/// Cache line size assumed for padding (the constexpr `std::hardware_destructive_interference_size` is not portable).
+inline constexpr std::size_t cache_line_size = 64;
+
+/// Hint the processor to fetch the cache line holding `p`, to be read soon.
+inline void prefetch(const void* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#elif defined(MC_SIMD_SSE2)
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#endif
+}
+
+/// Array-of-structs slot buffer: keys are stored interleaved with their values.
 ///
-/// A small, fixed-size, heap-allocated key/value cache with retention management, for use with regular types.
+/// A slot is occupied if it was filled in the current generation, so that clearing the buffer only takes a new generation.
+/// The keys and values of earlier generations are destroyed when their slots are filled again, or when purged. Keys and
+/// values are constructed in place when a slot is first filled, so neither has to be default constructible (nor copyable).
 ///
-template<std::regular Key, std::regular Val, std::size_t Size>
-class memo_cache {
-  static_assert(Size > 0);
-  static_assert(Size <= 128, "Semantic constraint: use this cache for small sizes only (see performance notes).");
+/// If `Aligned`, the slots are grouped in cache line aligned buckets (a power of two slots each, padded to whole cache
+/// lines), so that no slot straddles two cache lines unless it is larger than one, and lookups prefetch the buckets ahead.
+template<typename Key, typename Val, std::size_t Size, bool Aligned = false>
+class aos_buffer {
+  static constexpr std::uint32_t STALE = 0; // Never a current generation.
+
+  struct slot_t {
+    static constexpr std::uint8_t KEY = 1;
+    static constexpr std::uint8_t VAL = 2;
+
+    // NOTE: Trivially copyable keys and values are copied (and snapshot) as is, whether they are live or not.
+    static constexpr bool TRIVIAL = std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Val>;
+
+    uninitialized<Key> key;
+    uninitialized<Val> val;
+    std::uint32_t      generation = STALE;
+    std::uint8_t       live{}; // NOTE: `KEY` and `VAL` bits of the live objects, whatever the generation (no value if negative).
+
+    constexpr slot_t() noexcept = default;
+
+    constexpr slot_t(const slot_t&) requires TRIVIAL = default;
+    constexpr slot_t(const slot_t& other) requires (!TRIVIAL && std::copy_constructible<Key> && std::copy_constructible<Val>)
+      : generation(other.generation) {
+      construct_from(other);
+    }
+
+    constexpr slot_t(slot_t&&) requires TRIVIAL = default;
+    constexpr slot_t(slot_t&& other) noexcept(std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<Val>)
+      requires (!TRIVIAL)
+      : generation(other.generation) {
+      construct_from(std::move(other));
+    }
+
+    constexpr slot_t& operator=(const slot_t&) requires TRIVIAL = default;
+    constexpr slot_t& operator=(const slot_t& other) requires (!TRIVIAL && std::copy_constructible<Key> && std::copy_constructible<Val>) {
+      if (this != &other) {
+        destroy();
+        construct_from(other);
+        generation = other.generation;
+      }
+
+      return *this;
+    }
+
+    constexpr slot_t& operator=(slot_t&&) requires TRIVIAL = default;
+    constexpr slot_t& operator=(slot_t&& other) noexcept(std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<Val>)
+      requires (!TRIVIAL)
+    {
+      if (this != &other) {
+        destroy();
+        construct_from(std::move(other));
+        generation = other.generation;
+      }
+
+      return *this;
+    }
+
+    constexpr ~slot_t() requires std::is_trivially_destructible_v<Key> && std::is_trivially_destructible_v<Val> = default;
+    constexpr ~slot_t() {
+      destroy();
+    }
+
+    /// Construct copies of (or move) the live objects of `other`, in this slot with no live objects.
+    template<typename Slot>
+    constexpr void construct_from(Slot&& other) {
+      if (other.live & KEY) {
+        std::construct_at(&key.object, std::forward<Slot>(other).key.object);
+        live |= KEY;
+      }
+
+      if (other.live & VAL) {
+        std::construct_at(&val.object, std::forward<Slot>(other).val.object);
+        live |= VAL;
+      }
+    }
+
+    /// Assign the key, reusing the live key (and e.g. its capacity), if any.
+    template<typename Key_>
+    constexpr void assign_key(Key_&& k) {
+      if (live & KEY) {
+        key.object = std::forward<Key_>(k);
+      } else {
+        std::construct_at(&key.object, std::forward<Key_>(k));
+        live |= KEY;
+      }
+    }
 
-  template<typename K = Key, typename V = Val> struct key_value_slot_t {
-    K                key;
-    std::optional<V> val;
+    constexpr void destroy_value() noexcept {
+      if (live & VAL) {
+        live &= static_cast<std::uint8_t>(~VAL);
+        std::destroy_at(&val.object);
+      }
+    }
+
+    constexpr void destroy() noexcept {
+      destroy_value();
+
+      if (live & KEY) {
+        live = 0;
+        std::destroy_at(&key.object);
+      }
+    }
   };
 
-  using buffer_t = std::array<key_value_slot_t<Key, Val>, Size>;
+  static constexpr std::size_t PER_BUCKET = Aligned ? std::max(std::size_t{1}, std::bit_floor(cache_line_size / sizeof(slot_t))) : 1;
+  static constexpr std::size_t BUCKETS    = (Size + PER_BUCKET - 1) / PER_BUCKET;
+  static constexpr std::size_t PREFETCH_DISTANCE = 2; // In buckets.
 
-  buffer_t buffer;
-  std::size_t cursor{};
+  // NOTE: The slots past `Size` in the last bucket are never occupied.
+  struct alignas(Aligned ? cache_line_size : alignof(slot_t)) bucket_t {
+    std::array<slot_t, PER_BUCKET> slots;
+  };
 
-  /// Replace slot under cursor and shift cursor position. Returns a reference to the replaced slot value.
-  template<typename Key_, typename Val_>
-  Val& replace_and_shift(Key_&& key, Val_&& val) {
-    buffer[cursor] = {.key = std::forward<Key_>(key), .val = {std::forward<Val_>(val)}};
+  // NOTE: Slots that fit in a typical L1 data cache are not prefetched; the prefetches then only cost instructions.
+  static constexpr bool PREFETCH = Aligned && (BUCKETS > PREFETCH_DISTANCE) && (BUCKETS * sizeof(bucket_t) > 32 * 1024);
 
-    // SAFETY: The option value is occupied above.
-    auto& value = *(buffer[cursor].val);
+  std::array<bucket_t, BUCKETS> buckets;
+  std::uint32_t generation = 1;
+
+  [[nodiscard]] constexpr slot_t& slot(std::size_t i) noexcept {
+    return buckets[i / PER_BUCKET].slots[i % PER_BUCKET];
+  }
 
-    // Move the cursor over the buffer elements sequentially, creating FIFO behavior.
-    cursor = (cursor + 1) % Size; // Wrap; overwrite the oldest element next time around.
+  [[nodiscard]] constexpr const slot_t& slot(std::size_t i) const noexcept {
+    return buckets[i / PER_BUCKET].slots[i % PER_BUCKET];
+  }
 
-    return value;
+public:
+  /// Returns the index of the occupied slot holding `key`, or `Size` if there is none.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find(const K& key) const {
+    for (std::size_t b = 0; b < BUCKETS; ++b) {
+      if constexpr (PREFETCH) {
+        if (!std::is_constant_evaluated() && b + PREFETCH_DISTANCE < BUCKETS) {
+          prefetch(&buckets[b + PREFETCH_DISTANCE]);
+        }
+      }
+
+      for (std::size_t j = 0; j < PER_BUCKET; ++j) {
+        if (const auto& fSlot = buckets[b].slots[j]; (fSlot.generation == generation) && (fSlot.key.object == key)) {
+          return b * PER_BUCKET + j;
+        }
+      }
+    }
+
+    return Size;
+  }
+
+  static constexpr bool scans_backward = true;
+
+  /// Like `find`, but scans the slots backwards (wrapping around) from slot `from`, or from the last slot if `from == Size`.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find_backward(const K& key, std::size_t from) const {
+    const auto start = (from < Size) ? from : Size - 1;
+    for (std::size_t n = 0; n < Size; ++n) {
+      const auto i = (n <= start) ? start - n : start + Size - n;
+      if (const auto& fSlot = slot(i); (fSlot.generation == generation) && (fSlot.key.object == key)) {
+        return i;
+      }
+    }
+
+    return Size;
+  }
+
+  [[nodiscard]] constexpr bool is_occupied(std::size_t i) const noexcept {
+    return slot(i).generation == generation;
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr const Key& key(std::size_t i) const {
+    return slot(i).key.object;
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied, and not negative.
+  [[nodiscard]] constexpr Val& value(std::size_t i) {
+    return slot(i).val.object;
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied, and not negative.
+  [[nodiscard]] constexpr const Val& value(std::size_t i) const {
+    return slot(i).val.object;
+  }
+
+  /// Construct a new value in the storage of occupied slot `i`.
+  template<typename... Args>
+  constexpr Val& emplace_value(std::size_t i, Args&&... args) {
+    // NOTE: If construction throws, the slot is left unoccupied.
+    auto& s = slot(i);
+    s.generation = STALE;
+    s.destroy_value();
+    auto* val = std::construct_at(&s.val.object, std::forward<Args>(args)...);
+    s.live |= slot_t::VAL;
+    s.generation = generation;
+
+    return *val;
+  }
+
+  /// Fill slot `i` with a key and a value constructed in place.
+  template<typename Key_, typename... Args>
+  constexpr Val& emplace(std::size_t i, Key_&& key, Args&&... args) {
+    slot(i).generation = STALE;
+    slot(i).assign_key(std::forward<Key_>(key));
+
+    return emplace_value(i, std::forward<Args>(args)...);
+  }
+
+  /// Fill slot `i` with a key and no value (a negative entry).
+  template<typename Key_>
+  constexpr void emplace_negative(std::size_t i, Key_&& key) {
+    slot(i).generation = STALE;
+    slot(i).assign_key(std::forward<Key_>(key));
+    reset_value(i);
+    slot(i).generation = generation;
+  }
+
+  /// Destroy the value of occupied slot `i`, leaving a negative entry.
+  constexpr void reset_value(std::size_t i) {
+    slot(i).destroy_value();
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr bool is_negative(std::size_t i) const noexcept {
+    return (slot(i).live & slot_t::VAL) == 0;
+  }
+
+  /// Move the key and value out of occupied slot `i`, to be replaced right after.
+  [[nodiscard]] constexpr std::pair<Key, Val> take(std::size_t i) {
+    return {std::move(slot(i).key.object), std::move(slot(i).val.object)};
+  }
+
+  /// Empty slot `i`, destroying its key and value.
+  constexpr void erase(std::size_t i) {
+    slot(i).destroy();
+    slot(i).generation = STALE;
+  }
+
+  constexpr void clear() noexcept {
+    // NOTE: On the (theoretical) wrap-around of the generation, all slots have to be marked stale explicitly.
+    if (++generation == STALE) {
+      for (auto& bucket : buckets) {
+        for (auto& s : bucket.slots) {
+          s.generation = STALE;
+        }
+      }
+
+      generation = 1;
+    }
+  }
+
+  /// Whether the buffer is consistent (e.g. when loaded from a snapshot): no slot is of a later generation, which would be
+  /// occupied again after a `clear`, and the slots past `Size` are stale.
+  [[nodiscard]] constexpr bool valid() const noexcept {
+    if (generation == STALE) {
+      return false;
+    }
+
+    for (std::size_t i = 0; i < BUCKETS * PER_BUCKET; ++i) {
+      if (const auto g = slot(i).generation; g > generation || (i >= Size && g != STALE)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  constexpr void purge() {
+    for (auto& bucket : buckets) {
+      for (auto& s : bucket.slots) {
+        s.destroy();
+        s.generation = STALE;
+      }
+    }
+
+    generation = 1;
+  }
+};
+
+/// Struct-of-arrays slot buffer: a dense key array, an occupancy bitmask, and a value array that is only read on a hit.
+///
+/// The keys are scanned densely (a block at a time), so all of them are live, and have to be default constructible. The
+/// values are constructed in place when a slot is filled, so they need not be (nor copyable).
+template<typename Key, typename Val, std::size_t Size>
+class soa_buffer {
+  static_assert(std::default_initializable<Key>, "The soa and fingerprinted layouts require default constructible keys.");
+
+  // NOTE: Trivially copyable values are copied (and snapshot) as is, whether they are live or not.
+  static constexpr bool TRIVIAL = std::is_trivially_copyable_v<Val>;
+
+  std::array<Key, Size>                keys{};
+  bitmask<Size>                        occupied;
+  bitmask<Size>                        live; // Of slots holding a live value, whether occupied or not (none if negative).
+  std::array<uninitialized<Val>, Size> vals;
+
+  /// Construct copies of (or move) the live values of `other`, in this buffer with no live values.
+  template<typename Buffer>
+  constexpr void construct_values_from(Buffer&& other) {
+    using source_t = std::conditional_t<std::is_lvalue_reference_v<Buffer>, const Val&, Val&&>;
+
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (other.live.test(i)) {
+        std::construct_at(&vals[i].object, static_cast<source_t>(other.vals[i].object));
+        live.set(i);
+      }
+    }
+  }
+
+  constexpr void destroy_value(std::size_t i) noexcept {
+    if (live.test(i)) {
+      live.reset(i);
+      std::destroy_at(&vals[i].object);
+    }
+  }
+
+  constexpr void destroy_values() noexcept {
+    for (std::size_t i = 0; i < Size; ++i) {
+      destroy_value(i);
+    }
+  }
+
+public:
+  constexpr soa_buffer() = default;
+
+  constexpr soa_buffer(const soa_buffer&) requires TRIVIAL = default;
+  constexpr soa_buffer(const soa_buffer& other) requires (!TRIVIAL && std::copy_constructible<Key> && std::copy_constructible<Val>)
+    : keys(other.keys), occupied(other.occupied) {
+    construct_values_from(other);
+  }
+
+  constexpr soa_buffer(soa_buffer&&) requires TRIVIAL = default;
+  constexpr soa_buffer(soa_buffer&& other) noexcept(std::is_nothrow_move_constructible_v<Key> && std::is_nothrow_move_constructible_v<Val>)
+    requires (!TRIVIAL)
+    : keys(std::move(other.keys)), occupied(other.occupied) {
+    construct_values_from(std::move(other));
+  }
+
+  constexpr soa_buffer& operator=(const soa_buffer&) requires TRIVIAL = default;
+  constexpr soa_buffer& operator=(const soa_buffer& other) requires (!TRIVIAL && std::copyable<Key> && std::copy_constructible<Val>) {
+    if (this != &other) {
+      destroy_values();
+      keys     = other.keys;
+      occupied = other.occupied;
+      construct_values_from(other);
+    }
+
+    return *this;
+  }
+
+  constexpr soa_buffer& operator=(soa_buffer&&) requires TRIVIAL = default;
+  constexpr soa_buffer& operator=(soa_buffer&& other) noexcept(std::is_nothrow_move_assignable_v<Key> && std::is_nothrow_move_constructible_v<Val>)
+    requires (!TRIVIAL)
+  {
+    if (this != &other) {
+      destroy_values();
+      keys     = std::move(other.keys);
+      occupied = other.occupied;
+      construct_values_from(std::move(other));
+    }
+
+    return *this;
+  }
+
+  constexpr ~soa_buffer() requires std::is_trivially_destructible_v<Val> = default;
+  constexpr ~soa_buffer() {
+    destroy_values();
+  }
+
+public:
+  /// Returns the index of the occupied slot holding `key`, or `Size` if there is none.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find(const K& key) const {
+    return find_key(keys.data(), occupied.data(), Size, key);
+  }
+
+  static constexpr bool scans_backward = false;
+
+  // NOTE: The keys are compared a block at a time anyway, so the scan order hardly matters; they are scanned forwards.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find_backward(const K& key, std::size_t) const {
+    return find(key);
+  }
+
+  /// The occupancy of the `scan_block` slots starting at `base`, as a bitmask.
+  [[nodiscard]] constexpr std::uint64_t occupancy(std::size_t base) const noexcept {
+    return occupied.word(base);
+  }
+
+  [[nodiscard]] constexpr bool is_occupied(std::size_t i) const noexcept {
+    return occupied.test(i);
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr const Key& key(std::size_t i) const {
+    return keys[i];
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied, and not negative.
+  [[nodiscard]] constexpr Val& value(std::size_t i) {
+    return vals[i].object;
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied, and not negative.
+  [[nodiscard]] constexpr const Val& value(std::size_t i) const {
+    return vals[i].object;
+  }
+
+  /// Construct a new value in the storage of occupied slot `i`.
+  template<typename... Args>
+  constexpr Val& emplace_value(std::size_t i, Args&&... args) {
+    // NOTE: If construction throws, the slot is left unoccupied.
+    occupied.reset(i);
+    destroy_value(i);
+    auto* val = std::construct_at(&vals[i].object, std::forward<Args>(args)...);
+    live.set(i);
+    occupied.set(i);
+
+    return *val;
+  }
+
+  /// Fill slot `i` with a key and a value constructed in place.
+  template<typename Key_, typename... Args>
+  constexpr Val& emplace(std::size_t i, Key_&& key, Args&&... args) {
+    // NOTE: The slot is only marked occupied once both the key and value are in place.
+    occupied.reset(i);
+    keys[i] = std::forward<Key_>(key);
+
+    return emplace_value(i, std::forward<Args>(args)...);
+  }
+
+  /// Fill slot `i` with a key and no value (a negative entry).
+  template<typename Key_>
+  constexpr void emplace_negative(std::size_t i, Key_&& key) {
+    occupied.reset(i);
+    keys[i] = std::forward<Key_>(key);
+    reset_value(i);
+    occupied.set(i);
+  }
+
+  /// Destroy the value of occupied slot `i`, leaving a negative entry.
+  constexpr void reset_value(std::size_t i) {
+    destroy_value(i);
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr bool is_negative(std::size_t i) const noexcept {
+    return !live.test(i);
+  }
+
+  /// Move the key and value out of occupied slot `i`, to be replaced right after.
+  [[nodiscard]] constexpr std::pair<Key, Val> take(std::size_t i) {
+    return {std::move(keys[i]), std::move(vals[i].object)};
+  }
+
+  /// Empty slot `i`, destroying its value and resetting its key to a default-constructed one.
+  constexpr void erase(std::size_t i) {
+    occupied.reset(i);
+    keys[i] = Key{};
+    destroy_value(i);
+  }
+
+  constexpr void clear() noexcept {
+    // NOTE: The keys and values of unoccupied slots are stale, and replaced when the slots are filled again.
+    occupied.clear();
+  }
+
+  /// Whether the buffer is consistent (e.g. when loaded from a snapshot).
+  [[nodiscard]] constexpr bool valid() const noexcept {
+    return occupied.valid();
+  }
+
+  constexpr void purge() {
+    keys = {};
+    occupied.clear();
+    destroy_values();
+  }
+};
+
+/// Struct-of-arrays slot buffer with a hash fingerprint per slot. Lookups scan the (dense) fingerprints first, and only
+/// compare keys on a fingerprint match.
+template<typename Key, typename Val, std::size_t Size, typename Tag>
+class fingerprint_buffer {
+  std::array<Tag, Size>      tags{};
+  soa_buffer<Key, Val, Size> slots;
+
+  [[nodiscard]] static constexpr Tag tag_of(const Key& key) {
+    // NOTE: Uses the high bits, as user hashes of small keys often vary in the low bits only (hence the mixing, too).
+    return static_cast<Tag>(mix_hash(static_cast<std::uint64_t>(std::hash<Key>{}(key))) >> (64 - 8 * sizeof(Tag)));
+  }
+
+public:
+  /// Returns the index of the occupied slot holding `key`, or `Size` if there is none.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find(const K& key) const {
+    // NOTE: A key of another type may not hash like the equivalent `Key`, so it is compared with all occupied slots.
+    if constexpr (!std::same_as<K, Key>) {
+      return slots.find(key);
+    } else {
+      const auto tag = tag_of(key);
+
+      for (std::size_t base = 0; base < Size; base += scan_block) {
+        for (auto mask = slots.occupancy(base) & match_keys(tags.data() + base, std::min(scan_block, Size - base), tag); mask != 0;
+             mask &= mask - 1) {
+          if (const auto i = base + static_cast<std::size_t>(std::countr_zero(mask)); slots.key(i) == key) {
+            return i;
+          }
+        }
+      }
+
+      return Size;
+    }
+  }
+
+  static constexpr bool scans_backward = false;
+
+  // NOTE: The fingerprints are compared a block at a time anyway, so the scan order hardly matters; they are scanned forwards.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find_backward(const K& key, std::size_t) const {
+    return find(key);
+  }
+
+  [[nodiscard]] constexpr bool is_occupied(std::size_t i) const noexcept {
+    return slots.is_occupied(i);
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr const Key& key(std::size_t i) const {
+    return slots.key(i);
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr Val& value(std::size_t i) {
+    return slots.value(i);
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr const Val& value(std::size_t i) const {
+    return slots.value(i);
+  }
+
+  /// Construct a new value in the storage of occupied slot `i`.
+  template<typename... Args>
+  constexpr Val& emplace_value(std::size_t i, Args&&... args) {
+    return slots.emplace_value(i, std::forward<Args>(args)...);
+  }
+
+  /// Fill slot `i` with a key and a value constructed in place.
+  template<typename Key_, typename... Args>
+  constexpr Val& emplace(std::size_t i, Key_&& key, Args&&... args) {
+    auto& val = slots.emplace(i, std::forward<Key_>(key), std::forward<Args>(args)...);
+
+    // NOTE: Fingerprints the stored key, so that inserting by (e.g.) a string literal does not construct another `Key`.
+    tags[i] = tag_of(slots.key(i));
+
+    return val;
+  }
+
+  /// Fill slot `i` with a key and no value (a negative entry).
+  template<typename Key_>
+  constexpr void emplace_negative(std::size_t i, Key_&& key) {
+    slots.emplace_negative(i, std::forward<Key_>(key));
+    tags[i] = tag_of(slots.key(i));
+  }
+
+  /// Destroy the value of occupied slot `i`, leaving a negative entry.
+  constexpr void reset_value(std::size_t i) {
+    slots.reset_value(i);
+  }
+
+  // SAFETY: The caller guarantees that slot `i` is occupied.
+  [[nodiscard]] constexpr bool is_negative(std::size_t i) const noexcept {
+    return slots.is_negative(i);
+  }
+
+  /// Move the key and value out of occupied slot `i`, to be replaced right after.
+  [[nodiscard]] constexpr std::pair<Key, Val> take(std::size_t i) {
+    return slots.take(i);
+  }
+
+  /// Empty slot `i`, destroying its value and resetting its key to a default-constructed one.
+  constexpr void erase(std::size_t i) {
+    slots.erase(i);
+  }
+
+  constexpr void clear() noexcept {
+    slots.clear();
+  }
+
+  /// Whether the buffer is consistent (e.g. when loaded from a snapshot).
+  [[nodiscard]] constexpr bool valid() const noexcept {
+    return slots.valid();
+  }
+
+  constexpr void purge() {
+    tags = {};
+    slots.purge();
+  }
+};
+
+} // namespace detail
+
+/// Storage layouts, to be passed as cache option (e.g. `memo_cache<std::string, float, 64, mc::layout::soa>`).
+namespace layout {
+
+/// Store keys interleaved with their values. Hits read the value from the same cache line(s) as the key.
+struct aos : detail::layout_option {};
+
+/// Store keys, occupancy and values in separate arrays. Lookups read only keys, values are only read on a hit.
+struct soa : detail::layout_option {};
+
+/// Like `aos`, but with the slots grouped in cache line aligned buckets: padded so that a slot does not straddle two cache
+/// lines (unless it is larger than one), and so that the eviction state does not share a cache line with the slots.
+/// Lookups prefetch the buckets ahead of the scan. Speeds up scans over mid-size keys (e.g. 24-byte structs), at the cost
+/// of the padding.
+struct aligned : detail::layout_option {};
+
+/// Use `soa` for scannable (integral, enumeration and pointer) keys, and `aos` otherwise. This is the default.
+struct automatic : detail::layout_option {};
+
+/// Like `soa`, but with a hash fingerprint of type `Tag` stored for each key. Lookups compare the fingerprints many at a
+/// time (using SIMD instructions when enabled at compile time), and only compare keys with a matching fingerprint. Speeds
+/// up lookups for keys that are expensive to compare (e.g. strings or tuples). Requires `std::hash<Key>`.
+///
+/// With the default 8-bit fingerprints, a miss compares about one in 256 keys; wider fingerprints trade memory for fewer
+/// false matches.
+template<std::unsigned_integral Tag = std::uint8_t>
+  requires detail::simd_scannable<Tag>
+struct fingerprinted : detail::layout_option {};
+
+} // namespace layout
+
+/// Probing orders, to be passed as cache option (e.g. `memo_cache<std::string, float, 64, mc::probe::recent>`).
+///
+/// Probe state interface (`typename Probe::template state<Size>`):
+///
+///   - `last_hit()`: the slot to check before scanning, or `Size` if there is none.
+///   - `newest()`: the slot to start a backward scan from, or `Size` if there is none.
+///   - `on_hit(slot)` / `on_insert(slot)`: the entry in the slot was hit / inserted.
+///   - `clear()`: all slots are empty.
+///
+namespace probe {
+
+/// Scan the slots in order, from the first one. This is the default, and costs nothing.
+struct linear : detail::probe_option {
+  template<std::size_t Size>
+  struct state {
+    static constexpr bool enabled = false;
+
+    static constexpr void on_hit(std::size_t) noexcept {}
+    static constexpr void on_insert(std::size_t) noexcept {}
+    static constexpr void clear() noexcept {}
+  };
+};
+
+/// Check the most recently hit (or inserted) slot first, then scan backwards from the newest slot, so that a repeated key
+/// is found in a single comparison, and recently inserted keys in a few. Backward scans only apply to the `aos` and
+/// `aligned` layouts (the other layouts compare many keys at a time anyway), and follow insertion order with the FIFO
+/// policy only. Costs two indices, and an extra key comparison on misses.
+struct recent : detail::probe_option {
+  template<std::size_t Size>
+  class state {
+    detail::index_t<Size> last = Size;
+    detail::index_t<Size> head = Size;
+
+  public:
+    static constexpr bool enabled = true;
+
+    [[nodiscard]] constexpr std::size_t last_hit() const noexcept {
+      return last;
+    }
+
+    [[nodiscard]] constexpr std::size_t newest() const noexcept {
+      return head;
+    }
+
+    constexpr void on_hit(std::size_t slot) noexcept {
+      last = static_cast<detail::index_t<Size>>(slot);
+    }
+
+    constexpr void on_insert(std::size_t slot) noexcept {
+      last = static_cast<detail::index_t<Size>>(slot);
+      head = last;
+    }
+
+    constexpr void clear() noexcept {
+      last = Size;
+      head = Size;
+    }
+  };
+};
+
+} // namespace probe
+
+namespace detail {
+
+template<typename Layout, typename Key, typename Val, std::size_t Size>
+struct buffer_for {
+  using type = std::conditional_t<std::same_as<Layout, layout::soa> || (std::same_as<Layout, layout::automatic> && simd_scannable<Key>),
+                                  soa_buffer<Key, Val, Size>,
+                                  aos_buffer<Key, Val, Size>>;
+};
+
+template<typename Key, typename Val, std::size_t Size>
+struct buffer_for<layout::aligned, Key, Val, Size> {
+  using type = aos_buffer<Key, Val, Size, true>;
+};
+
+template<typename Tag, typename Key, typename Val, std::size_t Size>
+struct buffer_for<layout::fingerprinted<Tag>, Key, Val, Size> {
+  using type = fingerprint_buffer<Key, Val, Size, Tag>;
+};
+
+template<typename Layout, typename Key, typename Val, std::size_t Size>
+using buffer_for_t = typename buffer_for<Layout, Key, Val, Size>::type;
+
+} // namespace detail
+
+/// Eviction policies, to be passed as cache option (e.g. `memo_cache<int, float, 64, mc::policy::lru>`).
+///
+/// A policy decides which slot is (re)filled by the next insertion. Empty slots are always filled first, in order. All
+/// policies keep fixed-size metadata (at most a few bytes per slot) and never allocate.
+///
+/// Policy state interface (`typename Policy::template state<Size>`):
+///
+///   - `victim()`: the slot for the next insertion. May update metadata, but leaves the chosen slot resident.
+///   - `on_insert(slot, hash)`: the (last chosen) slot holds a new entry. `hash` is only computed if `uses_hash` is set.
+///   - `on_hit(slot)`: the entry in the slot was looked up. Does nothing at all unless `tracks_hits` is set.
+///   - `clear()`: all slots are empty.
+///   - `valid(occupied)`: whether the state (e.g. loaded from a snapshot) is consistent with the `occupied` slots.
+///
+/// Policies that set `weighs` also keep the entries within a weight budget (see `greedy_dual_size`):
+///
+///   - `on_weigh(slot, weight)`: the entry in the slot (newly inserted or refilled) has the given weight.
+///   - `over_budget(keep)`: the slot to evict to get within the budget, never `keep`; or `Size` if there is none.
+///   - `on_erase(slot)`: the entry in the slot was evicted, and the slot is empty.
+///
+namespace policy {
+
+/// First-in, first-out: evict the oldest entry. Hits are not tracked at all. This is the default.
+struct fifo : detail::eviction_option {
+  template<std::size_t Size>
+  class state {
+    std::size_t cursor{};
+
+  public:
+    static constexpr bool uses_hash = false;
+    static constexpr bool tracks_hits = false;
+    static constexpr bool weighs = false;
+
+    [[nodiscard]] constexpr std::size_t victim() const noexcept {
+      return cursor;
+    }
+
+    constexpr void on_insert(std::size_t slot, std::uint64_t) noexcept {
+      // Move the cursor over the slots sequentially, overwriting the oldest element next time around.
+      cursor = (slot + 1) % Size;
+    }
+
+    constexpr void on_hit(std::size_t) noexcept {}
+
+    constexpr void clear() noexcept {
+      cursor = 0;
+    }
+
+    [[nodiscard]] constexpr bool valid(const detail::bitmask<Size>&) const noexcept {
+      return cursor < Size;
+    }
+  };
+};
+
+/// CLOCK (second chance): FIFO, but entries that were hit since the hand last passed them get another round.
+/// Costs one bit per slot, set on every hit.
+struct clock : detail::eviction_option {
+  template<std::size_t Size>
+  class state {
+    detail::bitmask<Size> referenced;
+    std::size_t hand{};
+
+  public:
+    static constexpr bool uses_hash = false;
+    static constexpr bool tracks_hits = true;
+    static constexpr bool weighs = false;
+
+    [[nodiscard]] constexpr std::size_t victim() noexcept {
+      while (referenced.test(hand)) {
+        referenced.reset(hand);
+        hand = (hand + 1) % Size;
+      }
+
+      return hand;
+    }
+
+    constexpr void on_insert(std::size_t slot, std::uint64_t) noexcept {
+      referenced.reset(slot);
+      hand = (slot + 1) % Size;
+    }
+
+    constexpr void on_hit(std::size_t slot) noexcept {
+      referenced.set(slot);
+    }
+
+    constexpr void clear() noexcept {
+      referenced.clear();
+      hand = 0;
+    }
+
+    [[nodiscard]] constexpr bool valid(const detail::bitmask<Size>&) const noexcept {
+      return hand < Size && referenced.valid();
+    }
+  };
+};
+
+/// SIEVE: like CLOCK, but retained entries are not moved; the hand sweeps from the oldest to the newest entries, and
+/// new entries are inserted at the head. Quickly evicts entries that are never hit. Costs one bit and two indices per slot.
+struct sieve : detail::eviction_option {
+  template<std::size_t Size>
+  class state {
+    detail::slot_list<Size> queue;
+    detail::bitmask<Size>   visited;
+    std::size_t hand = detail::slot_list<Size>::none; // Next eviction candidate, or none (start at the oldest).
+
+  public:
+    static constexpr bool uses_hash = false;
+    static constexpr bool tracks_hits = true;
+    static constexpr bool weighs = false;
+
+    [[nodiscard]] constexpr std::size_t victim() noexcept {
+      if (queue.size() < Size) {
+        return queue.size();
+      }
+
+      auto slot = (hand != queue.none) ? hand : queue.oldest();
+      while (visited.test(slot)) {
+        visited.reset(slot);
+        const auto next = queue.newer_than(slot);
+        slot = (next != queue.none) ? next : queue.oldest();
+      }
+
+      hand = slot;
+
+      return slot;
+    }
+
+    constexpr void on_insert(std::size_t slot, std::uint64_t) noexcept {
+      if (queue.size() == Size) {
+        hand = queue.newer_than(slot);
+        queue.unlink(slot);
+      }
+
+      visited.reset(slot);
+      queue.push_front(slot);
+    }
+
+    constexpr void on_hit(std::size_t slot) noexcept {
+      visited.set(slot);
+    }
+
+    constexpr void clear() noexcept {
+      queue.clear();
+      visited.clear();
+      hand = queue.none;
+    }
+
+    // NOTE: Empty slots are filled in order, so the queue holds the occupied slots, and these are the first ones.
+    [[nodiscard]] constexpr bool valid(const detail::bitmask<Size>& occupied) const noexcept {
+      detail::bitmask<Size> members;
+
+      return queue.valid(members) && members == occupied && occupied.is_prefix(queue.size())
+          && (hand == queue.none || (hand < Size && members.test(hand)));
+    }
+  };
+};
+
+/// S3-FIFO: new entries enter a small FIFO queue (10% of the slots), and are only promoted to the main FIFO queue when
+/// hit while in there. Entries evicted from the main queue get another round for as long as they are hit (up to three
+/// times). Keys recently evicted from the small queue are remembered by fingerprint in a ghost queue, and enter the main
+/// queue directly when inserted again. Costs ~10 bytes per slot, and requires `std::hash<Key>`.
+struct s3fifo : detail::eviction_option {
+  template<std::size_t Size>
+  class state {
+    static constexpr std::size_t SMALL_SIZE = std::max(std::size_t{1}, Size / 10);
+    static constexpr std::uint8_t MAX_FREQ  = 3;
+
+    detail::slot_list<Size> small;
+    detail::slot_list<Size> main;
+    detail::bitmask<Size>   in_small;
+    std::array<std::uint8_t, Size>  freq{};
+    std::array<std::uint32_t, Size> fingerprints{}; // Of the entries in the slots.
+    std::array<std::uint32_t, Size> ghosts{};       // Of entries evicted from the small queue (zero is unused).
+    std::size_t ghost_cursor{};
+
+    [[nodiscard]] constexpr std::size_t filled() const noexcept {
+      return small.size() + main.size();
+    }
+
+    [[nodiscard]] constexpr std::size_t find_ghost(std::uint32_t fingerprint) const noexcept {
+      for (std::size_t base = 0; base < Size; base += detail::scan_block) {
+        if (const auto mask = detail::match_keys(ghosts.data() + base, std::min(detail::scan_block, Size - base), fingerprint); mask != 0) {
+          return base + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+      }
+
+      return Size;
+    }
+
+  public:
+    static constexpr bool uses_hash = true;
+    static constexpr bool tracks_hits = true;
+    static constexpr bool weighs = false;
+
+    [[nodiscard]] constexpr std::size_t victim() noexcept {
+      if (filled() < Size) {
+        return filled();
+      }
+
+      for (;;) {
+        if (small.size() >= SMALL_SIZE) {
+          const auto slot = small.oldest();
+          if (freq[slot] == 0) {
+            return slot;
+          }
+
+          // Promote to the main queue.
+          small.unlink(slot);
+          in_small.reset(slot);
+          freq[slot] = 0;
+          main.push_front(slot);
+        } else {
+          const auto slot = main.oldest();
+          if (freq[slot] == 0) {
+            return slot;
+          }
+
+          // Reinsert in the main queue.
+          --freq[slot];
+          main.move_to_front(slot);
+        }
+      }
+    }
+
+    constexpr void on_insert(std::size_t slot, std::uint64_t hash) noexcept {
+      if (filled() == Size) {
+        if (in_small.test(slot)) {
+          small.unlink(slot);
+          ghosts[ghost_cursor] = fingerprints[slot];
+          ghost_cursor         = (ghost_cursor + 1) % Size;
+        } else {
+          main.unlink(slot);
+        }
+      }
+
+      const auto fingerprint = std::max(std::uint32_t{1}, static_cast<std::uint32_t>(hash >> 32));
+
+      fingerprints[slot] = fingerprint;
+      freq[slot]         = 0;
+
+      if (const auto ghost = find_ghost(fingerprint); ghost != Size) {
+        ghosts[ghost] = 0;
+        in_small.reset(slot);
+        main.push_front(slot);
+      } else {
+        in_small.set(slot);
+        small.push_front(slot);
+      }
+    }
+
+    constexpr void on_hit(std::size_t slot) noexcept {
+      freq[slot] = std::min(MAX_FREQ, static_cast<std::uint8_t>(freq[slot] + 1));
+    }
+
+    constexpr void clear() noexcept {
+      small.clear();
+      main.clear();
+      in_small.clear();
+      ghosts = {};
+    }
+
+    // NOTE: Empty slots are filled in order, so the queues hold the occupied slots (each in one), and these are the first ones.
+    [[nodiscard]] constexpr bool valid(const detail::bitmask<Size>& occupied) const noexcept {
+      detail::bitmask<Size> members;
+
+      if (!small.valid(members) || members != in_small) {
+        return false;
+      }
+
+      return main.valid(members) && members == occupied && occupied.is_prefix(filled()) && ghost_cursor < Size;
+    }
+  };
+};
+
+/// Least recently used: evict the entry that was hit or inserted longest ago. Costs two indices per slot, and moving the
+/// entry to the front of the recency list on every hit.
+struct lru : detail::eviction_option {
+  template<std::size_t Size>
+  class state {
+    detail::slot_list<Size> recency;
+
+  public:
+    static constexpr bool uses_hash = false;
+    static constexpr bool tracks_hits = true;
+    static constexpr bool weighs = false;
+
+    [[nodiscard]] constexpr std::size_t victim() const noexcept {
+      return (recency.size() < Size) ? recency.size() : recency.oldest();
+    }
+
+    constexpr void on_insert(std::size_t slot, std::uint64_t) noexcept {
+      if (recency.size() == Size) {
+        recency.move_to_front(slot);
+      } else {
+        recency.push_front(slot);
+      }
+    }
+
+    constexpr void on_hit(std::size_t slot) noexcept {
+      recency.move_to_front(slot);
+    }
+
+    constexpr void clear() noexcept {
+      recency.clear();
+    }
+
+    // NOTE: Empty slots are filled in order, so the list holds the occupied slots, and these are the first ones.
+    [[nodiscard]] constexpr bool valid(const detail::bitmask<Size>& occupied) const noexcept {
+      detail::bitmask<Size> members;
+
+      return recency.valid(members) && members == occupied && occupied.is_prefix(recency.size());
+    }
+  };
+};
+
+/// GreedyDual-Size: evict the entry of the lowest priority, which is the inverse of its weight plus an inflation value
+/// as of its insertion or last hit. The inflation value rises to the priority of every evicted entry, so that (heavy)
+/// entries that were not hit for a while are evicted first. Entries are weighed by a `Weigher` (e.g. their size in bytes:
+/// `std::size_t operator()(const Key&, const Val&) const`), and the total weight is kept within a budget (`Budget` by
+/// default, zero for none) by evicting other entries on every insertion. Costs 16 bytes per slot, and a scan over all
+/// slots per eviction.
+template<typename Weigher, std::size_t Budget = 0>
+struct greedy_dual_size : detail::eviction_option {
+  using weigher = Weigher;
+
+  template<std::size_t Size>
+  class state {
+    std::array<double, Size>        priority{};
+    std::array<std::uint64_t, Size> weights{};
+    detail::bitmask<Size>           occupied;
+    std::size_t   count{};
+    std::uint64_t total{};
+    std::uint64_t budget = Budget;
+    double        inflation{};
+
+    [[nodiscard]] constexpr double priority_of(std::uint64_t weight) const noexcept {
+      return inflation + 1.0 / static_cast<double>(std::max(weight, std::uint64_t{1}));
+    }
+
+    /// Returns the occupied slot of the lowest priority other than `keep`, or `Size` if there is none.
+    [[nodiscard]] constexpr std::size_t lowest(std::size_t keep) const noexcept {
+      auto slot = Size;
+      for (std::size_t i = 0; i < Size; ++i) {
+        if (i != keep && occupied.test(i) && (slot == Size || priority[i] < priority[slot])) {
+          slot = i;
+        }
+      }
+
+      return slot;
+    }
+
+  public:
+    static constexpr bool uses_hash = false;
+    static constexpr bool tracks_hits = true;
+    static constexpr bool weighs = true;
+
+    [[nodiscard]] constexpr std::size_t victim() const noexcept {
+      if (count < Size) {
+        // NOTE: Entries evicted to get within the budget leave holes, so the first empty slot is searched for.
+        for (std::size_t i = 0; i < Size; ++i) {
+          if (!occupied.test(i)) {
+            return i;
+          }
+        }
+      }
+
+      return lowest(Size);
+    }
+
+    constexpr void on_insert(std::size_t slot, std::uint64_t) noexcept {
+      if (occupied.test(slot)) {
+        inflation = std::max(inflation, priority[slot]);
+        total -= weights[slot];
+      } else {
+        occupied.set(slot);
+        ++count;
+      }
+
+      weights[slot]  = 0;
+      priority[slot] = priority_of(0);
+    }
+
+    constexpr void on_hit(std::size_t slot) noexcept {
+      priority[slot] = priority_of(weights[slot]);
+    }
+
+    constexpr void on_weigh(std::size_t slot, std::uint64_t weight) noexcept {
+      total          = total - weights[slot] + weight;
+      weights[slot]  = weight;
+      priority[slot] = priority_of(weight);
+    }
+
+    [[nodiscard]] constexpr std::size_t over_budget(std::size_t keep) const noexcept {
+      return (budget != 0 && total > budget) ? lowest(keep) : Size;
+    }
+
+    constexpr void on_erase(std::size_t slot) noexcept {
+      inflation = std::max(inflation, priority[slot]);
+      total -= weights[slot];
+      weights[slot] = 0;
+      occupied.reset(slot);
+      --count;
+    }
+
+    [[nodiscard]] constexpr std::uint64_t total_weight() const noexcept {
+      return total;
+    }
+
+    constexpr void set_budget(std::uint64_t max_weight) noexcept {
+      budget = max_weight;
+    }
+
+    constexpr void clear() noexcept {
+      weights.fill(0);
+      occupied.clear();
+      count     = 0;
+      total     = 0;
+      inflation = 0;
+    }
+
+    [[nodiscard]] constexpr bool valid(const detail::bitmask<Size>& occupied_slots) const noexcept {
+      return occupied == occupied_slots && count == occupied.count();
+    }
+  };
+};
+
+} // namespace policy
+
+/// Admission filters, to be passed as cache option (e.g. `memo_cache<int, float, 64, mc::admission::tinylfu>`).
+///
+/// A filter decides whether a new key may replace the (live) entry chosen by the eviction policy, so that a burst of
+/// one-off keys (e.g. a scan) does not flush the working set. Rejected keys are not inserted; functions returning a
+/// reference to the inserted value then refer to a spare value outside of the slots, valid until the next insertion.
+///
+/// Admission state interface (`typename Admission::template state<Size>`):
+///
+///   - `on_access(hash)`: a key was hit (through a non-const member function) or is being inserted.
+///   - `admit(candidate, victim)`: whether a new key with hash `candidate` may replace the entry with hash `victim`.
+///   - `clear()`: forget all accesses.
+///
+namespace admission {
+
+/// Admit every new key. This is the default, and costs nothing.
+struct always : detail::admission_option {
+  template<std::size_t Size>
+  struct state {
+    static constexpr bool enabled = false;
+
+    static constexpr void on_access(std::uint64_t) noexcept {}
+
+    [[nodiscard]] static constexpr bool admit(std::uint64_t, std::uint64_t) noexcept {
+      return true;
+    }
+
+    static constexpr void clear() noexcept {}
+  };
+};
+
+/// TinyLFU: admit a new key only if its estimated access frequency is higher than that of the victim. Frequencies are
+/// estimated by a count-min sketch of four rows of 4-bit counters, behind a doorkeeper bloom filter that absorbs the
+/// first access of every key. All counters are halved every `10 * Size` accesses, so that the cache adapts to a shifting
+/// working set. Costs ~10 bytes per slot, hashing the key on every hit, and requires `std::hash<Key>`.
+struct tinylfu : detail::admission_option {
+  template<std::size_t Size>
+  class state {
+    static constexpr std::size_t ROWS      = 4;
+    static constexpr std::size_t WIDTH     = std::max(std::size_t{64}, std::bit_ceil(4 * Size)); // Counters per row.
+    static constexpr std::size_t DOOR_BITS = 4 * WIDTH;
+    static constexpr std::size_t SAMPLES   = 10 * Size;
+
+    static constexpr std::uint64_t MAX_COUNT = 15;
+
+    static_assert(WIDTH <= 0x10000, "Every row is indexed by 16 bits of the hash.");
+
+    std::array<std::uint64_t, ROWS * WIDTH / 16> counters{}; // Sixteen 4-bit counters per word.
+    detail::bitmask<DOOR_BITS> doorkeeper;
+    std::size_t samples{};
+
+    [[nodiscard]] static std::size_t counter_index(std::uint64_t hash, std::size_t row) noexcept {
+      return row * WIDTH + static_cast<std::size_t>((hash >> (16 * row)) & (WIDTH - 1));
+    }
+
+    [[nodiscard]] std::uint64_t count(std::size_t i) const noexcept {
+      return (counters[i / 16] >> (4 * (i % 16))) & MAX_COUNT;
+    }
+
+    [[nodiscard]] static std::pair<std::size_t, std::size_t> door_indices(std::uint64_t hash) noexcept {
+      const auto h = detail::mix_hash(hash);
+      return {static_cast<std::size_t>(h & (DOOR_BITS - 1)), static_cast<std::size_t>((h >> 32) & (DOOR_BITS - 1))};
+    }
+
+    [[nodiscard]] bool in_doorkeeper(std::uint64_t hash) const noexcept {
+      const auto [a, b] = door_indices(hash);
+      return doorkeeper.test(a) && doorkeeper.test(b);
+    }
+
+    [[nodiscard]] std::uint64_t estimate(std::uint64_t hash) const noexcept {
+      auto result = MAX_COUNT;
+      for (std::size_t row = 0; row < ROWS; ++row) {
+        result = std::min(result, count(counter_index(hash, row)));
+      }
+
+      return result + (in_doorkeeper(hash) ? 1 : 0);
+    }
+
+    void age() noexcept {
+      for (auto& word : counters) {
+        word = (word >> 1) & 0x7777'7777'7777'7777;
+      }
+
+      doorkeeper.clear();
+      samples = 0;
+    }
+
+  public:
+    static constexpr bool enabled = true;
+
+    void on_access(std::uint64_t hash) noexcept {
+      if (!in_doorkeeper(hash)) {
+        const auto [a, b] = door_indices(hash);
+        doorkeeper.set(a);
+        doorkeeper.set(b);
+      } else {
+        for (std::size_t row = 0; row < ROWS; ++row) {
+          if (const auto i = counter_index(hash, row); count(i) < MAX_COUNT) {
+            counters[i / 16] += std::uint64_t{1} << (4 * (i % 16));
+          }
+        }
+      }
+
+      if (++samples == SAMPLES) {
+        age();
+      }
+    }
+
+    [[nodiscard]] bool admit(std::uint64_t candidate, std::uint64_t victim) const noexcept {
+      return estimate(candidate) > estimate(victim);
+    }
+
+    void clear() noexcept {
+      counters = {};
+      doorkeeper.clear();
+      samples = 0;
+    }
+  };
+};
+
+} // namespace admission
+
+/// Entry expiry, to be passed as cache option (e.g. `memo_cache<int, float, 64, mc::expiry::ttl<>>`).
+///
+/// Expired entries are never returned, but stay resident until evicted by the eviction policy, or refreshed by inserting
+/// their key again.
+///
+/// Expiry state interface (`typename Expiry::template state<Size>`):
+///
+///   - `live(slot)`: the entry in the slot has not expired.
+///   - `stamp(slot)`: the slot holds a new value, expiring after the default time to live.
+///   - `clear()`: all slots are empty.
+///
+namespace expiry {
+
+/// Entries never expire. This is the default, and costs nothing.
+struct none : detail::expiry_option {
+  template<std::size_t Size>
+  struct state {
+    static constexpr bool enabled = false;
+
+    [[nodiscard]] static constexpr bool live(std::size_t) noexcept {
+      return true;
+    }
+
+    static constexpr void stamp(std::size_t) noexcept {}
+    static constexpr void stamp_negative(std::size_t) noexcept {}
+
+    static constexpr void clear() noexcept {}
+  };
+};
+
+/// Entries expire after a time to live, set for the whole cache (`set_time_to_live`) or per entry (on `insert`). Entries
+/// do not expire until a time to live is set. Negative entries may have a (shorter) time to live of their own
+/// (`set_negative_time_to_live`).
+///
+/// `Clock` is a `std::chrono` clock or any type with a static `now()` returning a `time_point` (e.g. a manual clock for
+/// testing). Deadlines are stored as 32-bit ticks of `Resolution` since an epoch, i.e. four bytes per slot. The epoch is
+/// moved forward on an insert half the range of the ticks after it (rebasing all deadlines, in `O(Size)`): with the
+/// default resolution of seconds that is every 68 years; with milliseconds, every 24 days. Times to live are therefore
+/// exact up to half the range, and may be cut short to it beyond.
+template<typename Clock = std::chrono::steady_clock, typename Resolution = std::chrono::seconds>
+struct ttl : detail::expiry_option {
+  using clock      = Clock;
+  using resolution = Resolution;
+
+  template<std::size_t Size>
+  class state {
+    using tick_t = std::uint32_t;
+
+    static constexpr tick_t NEVER = std::numeric_limits<tick_t>::max();
+
+    typename Clock::time_point epoch = Clock::now();
+    tick_t                     time_to_live = NEVER;
+    std::optional<tick_t>      negative_time_to_live; // Unless set, that of the other entries.
+    std::array<tick_t, Size>   deadlines{};
+
+    /// The ticks since the epoch, which may be past the range of the deadlines (until the next insert rebases them).
+    [[nodiscard]] std::uint64_t now() const {
+      const auto ticks = std::chrono::duration_cast<Resolution>(Clock::now() - epoch).count();
+      return static_cast<std::uint64_t>(std::max<decltype(ticks)>(ticks, 0));
+    }
+
+    /// Move the epoch forward by `ticks`, and the deadlines back (expired ones to zero).
+    void rebase(std::uint64_t ticks) {
+      epoch += std::chrono::duration_cast<typename Clock::duration>(Resolution{static_cast<typename Resolution::rep>(ticks)});
+
+      for (auto& deadline : deadlines) {
+        if (deadline != NEVER) {
+          deadline = (deadline > ticks) ? static_cast<tick_t>(deadline - ticks) : 0;
+        }
+      }
+    }
+
+    [[nodiscard]] static tick_t to_ticks(Resolution d) noexcept {
+      return static_cast<tick_t>(std::clamp<typename Resolution::rep>(d.count(), 0, NEVER));
+    }
+
+  public:
+    static constexpr bool enabled = true;
+
+    [[nodiscard]] bool live(std::size_t slot) const {
+      return deadlines[slot] == NEVER || now() < deadlines[slot];
+    }
+
+    void stamp(std::size_t slot) {
+      stamp(slot, time_to_live);
+    }
+
+    /// The slot holds a new value, expiring after `ttl` ticks.
+    void stamp(std::size_t slot, tick_t ttl) {
+      if (ttl == NEVER) {
+        deadlines[slot] = NEVER;
+        return;
+      }
+
+      auto t = now();
+      if (t + ttl >= NEVER && t >= NEVER / 2) {
+        rebase(t);
+        t = 0;
+      }
+
+      deadlines[slot] = static_cast<tick_t>(std::min<std::uint64_t>(t + ttl, NEVER - 1));
+    }
+
+    void stamp(std::size_t slot, Resolution ttl) {
+      stamp(slot, to_ticks(ttl));
+    }
+
+    /// The slot holds a new negative entry.
+    void stamp_negative(std::size_t slot) {
+      stamp(slot, negative_time_to_live.value_or(time_to_live));
+    }
+
+    void set_time_to_live(Resolution ttl) noexcept {
+      time_to_live = to_ticks(ttl);
+    }
+
+    void set_negative_time_to_live(Resolution ttl) noexcept {
+      negative_time_to_live = to_ticks(ttl);
+    }
+
+    void clear() {
+      epoch = Clock::now();
+    }
+  };
+};
+
+} // namespace expiry
+
+/// Cache statistics, as counted by `mc::stats::counters`.
+struct cache_stats {
+  std::uint64_t hits{};       // Lookups finding a (live) entry.
+  std::uint64_t misses{};     // Lookups not finding a (live) entry.
+  std::uint64_t inserts{};    // Entries inserted into a slot.
+  std::uint64_t overwrites{}; // Values replaced in place, for keys that were already resident.
+  std::uint64_t evictions{};  // Entries replaced by inserts.
+  std::uint64_t probes{};     // Slots scanned by lookups, in total.
+
+  /// The fraction of lookups that were hits, or zero without lookups.
+  [[nodiscard]] double hit_ratio() const noexcept {
+    const auto lookups = hits + misses;
+    return lookups != 0 ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+  }
+
+  cache_stats& operator+=(const cache_stats& other) noexcept {
+    hits += other.hits;
+    misses += other.misses;
+    inserts += other.inserts;
+    overwrites += other.overwrites;
+    evictions += other.evictions;
+    probes += other.probes;
+    return *this;
+  }
+
+  bool operator==(const cache_stats&) const = default;
+};
+
+namespace detail {
+
+/// A statistics counter, incremented atomically (but unordered), so that it can be read while the cache is in use.
+class counter {
+  std::atomic<std::uint64_t> n{};
+
+public:
+  counter() = default;
+  counter(const counter& other) noexcept : n{other.load()} {}
+
+  counter& operator=(const counter& other) noexcept {
+    n.store(other.load(), std::memory_order_relaxed);
+    return *this;
+  }
+
+  void add(std::uint64_t k = 1) noexcept {
+    n.fetch_add(k, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t load() const noexcept {
+    return n.load(std::memory_order_relaxed);
+  }
+};
+
+} // namespace detail
+
+/// Cache statistics, to be passed as cache option (e.g. `memo_cache<int, float, 64, mc::stats::counters>`).
+///
+/// Statistics state interface (`typename Stats::template state<Key, Val>`):
+///
+///   - `on_lookup(hit, probes)`: a lookup scanned `probes` slots, and found a live entry (or not).
+///   - `on_insert()`, `on_overwrite()`: an entry was inserted into a slot, or a resident entry got a new value.
+///   - `on_evict(key, val)`: the entry is about to be replaced by an insert.
+///
+namespace stats {
+
+/// No statistics. This is the default, and costs nothing.
+struct none : detail::stats_option {
+  template<typename Key, typename Val>
+  struct state {
+    static constexpr bool enabled = false;
+
+    static constexpr void on_lookup(bool, std::size_t) noexcept {}
+    static constexpr void on_insert() noexcept {}
+    static constexpr void on_overwrite() noexcept {}
+    static constexpr void on_evict(const Key&, const Val&) noexcept {}
+  };
+};
+
+/// Count all operations (see `cache_stats`), using a relaxed atomic increment each, so that the statistics can be read
+/// from any thread, and counted by concurrent lookups of a `concurrent_memo_cache`. Optionally calls an eviction hook.
+struct counters : detail::stats_option {
+  template<typename Key, typename Val>
+  class state {
+    detail::counter hits;
+    detail::counter misses;
+    detail::counter inserts;
+    detail::counter overwrites;
+    detail::counter evictions;
+    detail::counter probes;
+
+    std::function<void(const Key&, const Val&)> eviction_hook;
+
+  public:
+    static constexpr bool enabled = true;
+
+    void on_lookup(bool hit, std::size_t n) noexcept {
+      (hit ? hits : misses).add();
+      probes.add(n);
+    }
+
+    void on_insert() noexcept {
+      inserts.add();
+    }
+
+    void on_overwrite() noexcept {
+      overwrites.add();
+    }
+
+    void on_evict(const Key& key, const Val& val) {
+      evictions.add();
+
+      if (eviction_hook) {
+        eviction_hook(key, val);
+      }
+    }
+
+    void set_eviction_hook(std::function<void(const Key&, const Val&)> hook) {
+      eviction_hook = std::move(hook);
+    }
+
+    [[nodiscard]] cache_stats load() const noexcept {
+      return {.hits       = hits.load(),
+              .misses     = misses.load(),
+              .inserts    = inserts.load(),
+              .overwrites = overwrites.load(),
+              .evictions  = evictions.load(),
+              .probes     = probes.load()};
+    }
+
+    void reset() noexcept {
+      hits       = {};
+      misses     = {};
+      inserts    = {};
+      overwrites = {};
+      evictions  = {};
+      probes     = {};
+    }
+  };
+};
+
+} // namespace stats
+
+namespace detail {
+
+/// The header of a cache snapshot image, followed by the raw slot buffer and eviction state. The header is 64 bytes, so
+/// that the state is suitably aligned in a memory-mapped file.
+struct snapshot_header {
+  static constexpr std::array<char, 8> MAGIC   = {'m', 'e', 'm', 'o', 'c', 'a', 'c', 'h'};
+  static constexpr std::uint32_t       VERSION = 1;
+
+  std::array<char, 8> magic = MAGIC;
+  std::uint32_t       version{VERSION};
+  std::uint32_t       byte_order{0x01020304}; // Detects images written on a machine of different endianness.
+  std::uint64_t       key_size{};
+  std::uint64_t       val_size{};
+  std::uint64_t       size{};
+  std::uint64_t       buffer_size{};
+  std::uint64_t       eviction_size{};
+  std::uint64_t       reserved{};
+
+  bool operator==(const snapshot_header&) const = default;
+};
+
+static_assert(sizeof(snapshot_header) == 64);
+
+} // namespace detail
+
+///
+/// A small, fixed-size key/value cache with retention management, for use with movable keys (that are equality comparable)
+/// and values. The slots are constructed on insert, so move-only values (e.g. `std::unique_ptr`) are stored as is; the cache
+/// is copyable if its keys and values are. Only the `soa` and `fingerprinted` layouts require default constructible keys.
+///
+/// Lookup is a linear scan over the keys. Integral, enumeration and pointer keys are stored densely and compared many at
+/// a time using SIMD instructions (when enabled at compile time), which allows for somewhat larger cache sizes.
+///
+/// The cache behavior can be customized by passing options:
+///
+///   - `mc::layout::aos`, `mc::layout::aligned`, `mc::layout::soa`, `mc::layout::fingerprinted<>` or
+///     `mc::layout::automatic` (default): the slot storage layout.
+///   - `mc::policy::fifo` (default), `mc::policy::clock`, `mc::policy::sieve`, `mc::policy::s3fifo`, `mc::policy::lru` or
+///     `mc::policy::greedy_dual_size<Weigher, Budget>`: the eviction policy.
+///   - `mc::expiry::none` (default) or `mc::expiry::ttl<Clock, Resolution>`: entry expiry.
+///   - `mc::stats::none` (default) or `mc::stats::counters`: statistics.
+///   - `mc::admission::always` (default) or `mc::admission::tinylfu`: the admission filter for new keys.
+///   - `mc::probe::linear` (default) or `mc::probe::recent`: the order in which slots are probed by lookups.
+///
+/// The cache is usable in constant evaluation, unless an option requires hashing keys (`mc::layout::fingerprinted<>`,
+/// `mc::policy::s3fifo`, `mc::admission::tinylfu`), a clock (`mc::expiry::ttl<>`) or atomics (`mc::stats::counters`).
+///
+/// NOTE: All storage is inline; use `dynamic_memo_cache` for a capacity chosen at runtime, or storage from an allocator.
+///
+template<std::movable Key, std::movable Val, std::size_t Size, typename... Options>
+  requires std::equality_comparable<Key>
+class memo_cache {
+  static_assert(Size > 0);
+  static_assert(Size <= detail::max_size<Key>, "Semantic constraint: use this cache for small sizes only (see performance notes).");
+  static_assert(detail::valid_options<Options...>, "Options must be cache options, each kind specified at most once.");
+  static_assert(detail::option_count<detail::lock_option, Options...> == 0, "Lock options only apply to concurrent caches.");
+  static_assert(detail::option_count<detail::storage_option, Options...> == 0, "Storage options only apply to memoized functions.");
+
+  using layout_t = detail::select_option_t<detail::layout_option, layout::automatic, Options...>;
+  using buffer_t = detail::buffer_for_t<layout_t, Key, Val, Size>;
+  using policy_t = detail::select_option_t<detail::eviction_option, policy::fifo, Options...>;
+  using expiry_t = detail::select_option_t<detail::expiry_option, expiry::none, Options...>;
+
+  using expiry_state_t = typename expiry_t::template state<Size>;
+  using stats_state_t  = typename detail::select_option_t<detail::stats_option, stats::none, Options...>::template state<Key, Val>;
+  using admission_state_t = typename detail::select_option_t<detail::admission_option, admission::always, Options...>::template state<Size>;
+  using probe_state_t     = typename detail::select_option_t<detail::probe_option, probe::linear, Options...>::template state<Size>;
+
+  static constexpr bool USES_HASH = policy_t::template state<Size>::uses_hash || admission_state_t::enabled;
+  static constexpr bool WEIGHS    = policy_t::template state<Size>::weighs;
+
+  buffer_t buffer;
+  typename policy_t::template state<Size> eviction;
+  [[no_unique_address]] expiry_state_t expiry;
+  [[no_unique_address]] mutable stats_state_t stats; // NOTE: Also counts lookups through const member functions.
+  [[no_unique_address]] admission_state_t admission;
+  [[no_unique_address]] probe_state_t probe;
+
+  // The value of the last key rejected by the admission filter.
+  [[no_unique_address]] std::conditional_t<admission_state_t::enabled, std::optional<Val>, std::tuple<>> rejected;
+
+  static constexpr bool SNAPSHOTS = std::is_trivially_copyable_v<buffer_t>
+                                 && std::is_trivially_copyable_v<typename policy_t::template state<Size>>
+                                 && !expiry_state_t::enabled; // Deadlines are relative to a clock epoch.
+
+  static constexpr std::size_t SNAPSHOT_SIZE =
+    sizeof(detail::snapshot_header) + sizeof(buffer_t) + sizeof(typename policy_t::template state<Size>);
+
+  /// Returns the header of snapshot images of this cache type.
+  static constexpr detail::snapshot_header expected_header() noexcept {
+    return {.key_size      = sizeof(Key),
+            .val_size      = sizeof(Val),
+            .size          = Size,
+            .buffer_size   = sizeof(buffer_t),
+            .eviction_size = sizeof(typename policy_t::template state<Size>)};
+  }
+
+  template<typename Key_>
+  [[nodiscard]] static constexpr std::uint64_t hash_of(const Key_& key) {
+    return detail::mix_hash(static_cast<std::uint64_t>(std::hash<Key>{}(key)));
+  }
+
+  /// Record a hit on (occupied) slot `i`.
+  constexpr void on_hit(std::size_t i) {
+    eviction.on_hit(i);
+    probe.on_hit(i);
+
+    if constexpr (admission_state_t::enabled) {
+      admission.on_access(hash_of(buffer.key(i)));
+    }
+  }
+
+  /// Weigh the (new) entry in slot `i`, and evict other entries until the total weight is within the budget.
+  constexpr void weigh(std::size_t i) {
+    if constexpr (WEIGHS) {
+      eviction.on_weigh(i, static_cast<std::uint64_t>(typename policy_t::weigher{}(std::as_const(buffer.key(i)), std::as_const(buffer.value(i)))));
+      evict_over_budget(i);
+    }
+  }
+
+  /// Evict entries other than slot `i` (if any) until the total weight is within the budget.
+  constexpr void evict_over_budget(std::size_t i) {
+    for (auto slot = eviction.over_budget(i); slot != Size; slot = eviction.over_budget(i)) {
+      if constexpr (stats_state_t::enabled) {
+        if (!buffer.is_negative(slot)) {
+          stats.on_evict(buffer.key(slot), buffer.value(slot));
+        }
+      }
+
+      buffer.erase(slot);
+      eviction.on_erase(slot);
+    }
+  }
+
+  /// Replace the slot selected by the eviction policy, constructing the value in place from `args` (or a negative entry, if
+  /// `args` is `detail::no_value_t`). Returns the index of the replaced slot, or `Size` if the admission filter rejected
+  /// the key (a value is then constructed in `rejected`). The replaced entry (if any, and not negative) is moved into
+  /// `evicted`, unless it is null.
+  template<typename Key_, typename... Args>
+  constexpr std::size_t replace_and_shift_slot(std::optional<std::pair<Key, Val>>* evicted, Key_&& key, Args&&... args) {
+    constexpr bool NEGATIVE = (sizeof...(Args) == 1) && (std::same_as<std::remove_cvref_t<Args>, detail::no_value_t> && ...);
+
+    std::uint64_t hash{};
+    if constexpr (USES_HASH) {
+      hash = hash_of(key);
+    }
+
+    const auto slot = eviction.victim();
+
+    if constexpr (admission_state_t::enabled) {
+      admission.on_access(hash);
+
+      // NOTE: Empty slots and expired entries are always replaced.
+      if (buffer.is_occupied(slot) && expiry.live(slot) && !admission.admit(hash, hash_of(buffer.key(slot)))) {
+        if constexpr (!NEGATIVE) {
+          rejected.emplace(std::forward<Args>(args)...);
+        }
+
+        return Size;
+      }
+    }
+
+    // NOTE: Negative entries are not counted as evictions, as there is no value to pass to the eviction hook.
+    if (buffer.is_occupied(slot) && !buffer.is_negative(slot)) {
+      if constexpr (stats_state_t::enabled) {
+        stats.on_evict(buffer.key(slot), buffer.value(slot));
+      }
+
+      if (evicted) {
+        evicted->emplace(buffer.take(slot));
+      }
+    }
+
+    if constexpr (NEGATIVE) {
+      buffer.emplace_negative(slot, std::forward<Key_>(key));
+      eviction.on_insert(slot, hash);
+      probe.on_insert(slot);
+      expiry.stamp_negative(slot);
+    } else {
+      buffer.emplace(slot, std::forward<Key_>(key), std::forward<Args>(args)...);
+      eviction.on_insert(slot, hash);
+      probe.on_insert(slot);
+      weigh(slot);
+      expiry.stamp(slot);
+    }
+
+    stats.on_insert();
+
+    return slot;
+  }
+
+  /// Replace the slot selected by the eviction policy, constructing the value in place from `args`. Returns a reference to
+  /// the replaced slot value.
+  template<typename Key_, typename... Args>
+  constexpr Val& replace_and_shift(Key_&& key, Args&&... args) {
+    const auto slot = replace_and_shift_slot(nullptr, std::forward<Key_>(key), std::forward<Args>(args)...);
+
+    if constexpr (admission_state_t::enabled) {
+      if (slot == Size) {
+        return *rejected;
+      }
+    }
+
+    return buffer.value(slot);
+  }
+
+  /// Insert a key/value pair, overwriting the value of the key if it is (still) resident. Returns the index of the slot,
+  /// or `Size` if the admission filter rejected the key.
+  template<typename Key_, typename Val_>
+  constexpr std::size_t insert_slot(Key_&& key, Val_&& val) {
+    // Overwrite values for identical keys.
+    if (const auto i = find_slot(key); i != Size) {
+      if (buffer.is_negative(i)) {
+        refill(i, std::forward<Val_>(val));
+        return i;
+      }
+
+      buffer.value(i) = std::forward<Val_>(val);
+      on_hit(i);
+      weigh(i);
+      expiry.stamp(i);
+      stats.on_overwrite();
+
+      return i;
+    }
+
+    return replace_and_shift_slot(nullptr, std::forward<Key_>(key), std::forward<Val_>(val));
+  }
+
+  /// Replace the value in (occupied) slot `i`, constructing it in place from `args`. Returns a reference to the new value.
+  template<typename... Args>
+  constexpr Val& refill(std::size_t i, Args&&... args) {
+    auto& value = buffer.emplace_value(i, std::forward<Args>(args)...);
+    on_refill(i);
+
+    return value;
+  }
+
+  /// Record that (occupied) slot `i` holds a new value, for the same key.
+  constexpr void on_refill(std::size_t i) {
+    on_hit(i);
+    weigh(i);
+    expiry.stamp(i);
+    stats.on_overwrite();
+  }
+
+  /// Replace the value in (occupied) slot `i` by a negative entry.
+  constexpr void refill_negative(std::size_t i) {
+    buffer.reset_value(i);
+    on_hit(i);
+
+    if constexpr (WEIGHS) {
+      eviction.on_weigh(i, 0);
+    }
+
+    expiry.stamp_negative(i);
+    stats.on_overwrite();
+  }
+
+  /// Insert a negative entry for `key`, replacing the value of the key if it is (still) resident. Returns the index of the
+  /// slot, or `Size` if the admission filter rejected the key.
+  template<typename Key_>
+  constexpr std::size_t insert_negative_slot(Key_&& key) {
+    if (const auto i = find_slot(key); i != Size) {
+      refill_negative(i);
+      return i;
+    }
+
+    return replace_and_shift_slot(nullptr, std::forward<Key_>(key), detail::no_value_t{});
+  }
+
+  /// Returns the index of the slot holding `key`, or `Size` if there is none. The entry may have expired, or be negative.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find_slot(const K& key) const {
+    if constexpr (probe_state_t::enabled) {
+      if (const auto i = probe.last_hit(); i != Size && buffer.is_occupied(i) && buffer.key(i) == key) {
+        return i;
+      }
+
+      return buffer.find_backward(key, probe.newest());
+    } else {
+      return buffer.find(key);
+    }
+  }
+
+  /// Returns the number of slots probed by `find_slot` to find slot `i` (or to miss, if `i == Size`).
+  [[nodiscard]] constexpr std::size_t probes_to(std::size_t i) const noexcept {
+    if constexpr (probe_state_t::enabled) {
+      if (i != Size && i == probe.last_hit()) {
+        return 1;
+      }
+
+      if constexpr (buffer_t::scans_backward) {
+        const auto from = (probe.newest() < Size) ? probe.newest() : Size - 1;
+        return 1 + ((i != Size) ? (from + Size - i) % Size + 1 : Size);
+      } else {
+        return 1 + ((i != Size) ? i + 1 : Size);
+      }
+    } else {
+      return (i != Size) ? i + 1 : Size;
+    }
+  }
+
+  /// Like `find_slot`, but counted as a lookup (a hit if the entry is live).
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t lookup_slot(const K& key) const {
+    const auto i = find_slot(key);
+
+    if constexpr (stats_state_t::enabled) {
+      stats.on_lookup(i != Size && expiry.live(i), probes_to(i));
+    }
+
+    return i;
+  }
+
+  /// Returns the index of the slot holding a live entry for `key` (which may be negative), or `Size` if there is none.
+  /// Counted as a lookup.
+  template<typename K>
+  [[nodiscard]] constexpr std::size_t find_live(const K& key) const {
+    const auto i = lookup_slot(key);
+    return (i != Size && expiry.live(i)) ? i : Size;
+  }
+
+  template<typename K>
+  [[nodiscard]] constexpr Val* find_impl(const K& key) {
+    if (const auto i = find_live(key); i != Size) {
+      on_hit(i);
+
+      // SAFETY: The slot value was found by definition, unless the entry is negative.
+      return buffer.is_negative(i) ? nullptr : &buffer.value(i);
+    }
+
+    return nullptr;
+  }
+
+  template<typename K>
+  [[nodiscard]] constexpr const Val* find_impl(const K& key) const {
+    if (const auto i = find_live(key); i != Size && !buffer.is_negative(i)) {
+      // SAFETY: The slot value was found by definition.
+      return &buffer.value(i);
+    }
+
+    return nullptr;
+  }
+
+  /// Insert a value constructed in place from `args`, replacing the value of the key if it is (still) resident.
+  template<typename Key_, typename... Args>
+  constexpr Val& upsert(Key_&& key, Args&&... args) {
+    if (const auto i = find_slot(key); i != Size) {
+      return refill(i, std::forward<Args>(args)...);
+    }
+
+    return replace_and_shift(std::forward<Key_>(key), std::forward<Args>(args)...);
+  }
+
+  template<typename T>
+  [[nodiscard]] static constexpr std::optional<std::reference_wrapper<T>> as_optional_ref(T* val) noexcept {
+    return val ? std::optional{std::ref(*val)} : std::nullopt;
+  }
+
+public:
+  /// Get the (fixed) size of the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// assert(c.size() == 4);
+  /// ```
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return Size;
+  }
+
+  /// Insert a key/value pair.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// assert(!c.find("hello").has_value());
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").has_value());
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  template<typename Key_, typename Val_>
+  constexpr void insert(Key_&& key, Val_&& val) requires (std::assignable_from<Key, Key_> || std::convertible_to<Key_, Key>)
+                                            && (std::assignable_from<Val, Val_> || std::convertible_to<Val_, Val>)
+  {
+    insert_slot(std::forward<Key_>(key), std::forward<Val_>(val));
+  }
+
+  /// Insert a key/value pair, and return the entry it replaced (if any), moved out of the cache: the previous value of the
+  /// key, or the entry evicted to make room. Its storage (e.g. a buffer) can then be reused for the next value to insert,
+  /// rather than destroyed. Entries evicted to meet a weight budget are destroyed as usual.
+  ///
+  /// If the admission filter rejects the key (see `mc::admission`), nothing is replaced, and the new entry itself is
+  /// returned instead, so that no value is lost: it can be told apart from an evicted entry by its key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, std::vector<int>, 1> c;
+  ///
+  /// assert(!c.insert_and_take_evicted(1, std::vector<int>(100)).has_value());
+  ///
+  /// auto evicted = c.insert_and_take_evicted(2, std::vector<int>(100));
+  ///
+  /// assert(evicted.has_value() && evicted->first == 1);
+  ///
+  /// // Reuse the evicted buffer for the next value.
+  /// auto recycled = std::move(evicted->second);
+  /// recycled.assign(100, 3);
+  /// c.insert(3, std::move(recycled));
+  /// ```
+  template<typename Key_, typename Val_>
+  constexpr std::optional<std::pair<Key, Val>> insert_and_take_evicted(Key_&& key, Val_&& val)
+    requires (std::assignable_from<Key, Key_> || std::convertible_to<Key_, Key>) && std::constructible_from<Val, Val_>
+  {
+    std::optional<std::pair<Key, Val>> evicted;
+
+    if (const auto i = find_slot(key); i != Size) {
+      if (buffer.is_negative(i)) {
+        refill(i, std::forward<Val_>(val));
+      } else {
+        // NOTE: The slot key is moved out along with the value, and replaced by the (equal) key passed in, so that keys
+        //       need not be copyable.
+        evicted.emplace(buffer.take(i));
+        buffer.emplace(i, std::forward<Key_>(key), std::forward<Val_>(val));
+        on_refill(i);
+      }
+    } else if (replace_and_shift_slot(&evicted, std::forward<Key_>(key), std::forward<Val_>(val)) == Size) {
+      if constexpr (admission_state_t::enabled) {
+        // NOTE: A rejected key is left untouched (only its value is constructed, in `rejected`).
+        evicted.emplace(std::forward<Key_>(key), *std::move(rejected));
+        rejected.reset();
+      }
+    }
+
+    return evicted;
+  }
+
+  /// Insert a key/value pair that expires after `ttl`, rather than the cache time to live.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4, mc::expiry::ttl<>> c;
+  ///
+  /// c.insert("hello", 42, std::chrono::seconds{10});
+  ///
+  /// assert(c.contains("hello"));
+  /// ```
+  template<typename Key_, typename Val_, typename Rep, typename Period>
+  void insert(Key_&& key, Val_&& val, std::chrono::duration<Rep, Period> ttl) requires expiry_state_t::enabled
+                                                                                  && (std::assignable_from<Key, Key_> || std::convertible_to<Key_, Key>)
+                                                                                  && (std::assignable_from<Val, Val_> || std::convertible_to<Val_, Val>)
+  {
+    if (const auto i = insert_slot(std::forward<Key_>(key), std::forward<Val_>(val)); i != Size) {
+      expiry.stamp(i, std::chrono::duration_cast<typename expiry_t::resolution>(ttl));
+    }
+  }
+
+  /// Set the maximum total weight of the entries (zero for none), evicting entries until it is met.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// struct length {
+  ///   std::size_t operator()(int, const std::string& s) const { return s.size(); }
+  /// };
+  ///
+  /// memo_cache<int, std::string, 8, mc::policy::greedy_dual_size<length>> c;
+  ///
+  /// c.insert(1, std::string(600, 'x'));
+  /// c.insert(2, std::string(300, 'x'));
+  /// c.set_weight_budget(500);
+  ///
+  /// assert(!c.contains(1));
+  /// assert(c.total_weight() == 300);
+  /// ```
+  constexpr void set_weight_budget(std::size_t max_weight) requires WEIGHS {
+    eviction.set_budget(max_weight);
+    evict_over_budget(Size);
+  }
+
+  /// Get the total weight of the entries (as weighed on insertion).
+  [[nodiscard]] constexpr std::size_t total_weight() const noexcept requires WEIGHS {
+    return static_cast<std::size_t>(eviction.total_weight());
+  }
+
+  /// Set the time to live of entries inserted from now on (entries do not expire until it is set), truncated to the
+  /// expiry resolution.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4, mc::expiry::ttl<>> c;
+  ///
+  /// c.set_time_to_live(std::chrono::minutes{5});
+  /// ```
+  template<typename Rep, typename Period>
+  void set_time_to_live(std::chrono::duration<Rep, Period> ttl) noexcept requires expiry_state_t::enabled {
+    expiry.set_time_to_live(std::chrono::duration_cast<typename expiry_t::resolution>(ttl));
+  }
+
+  /// Set the time to live of negative entries inserted from now on, rather than the cache time to live (e.g. a shorter one,
+  /// so that keys that get a value are not missed for long).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4, mc::expiry::ttl<>> c;
+  ///
+  /// c.set_time_to_live(std::chrono::minutes{5});
+  /// c.set_negative_time_to_live(std::chrono::seconds{10});
+  /// ```
+  template<typename Rep, typename Period>
+  void set_negative_time_to_live(std::chrono::duration<Rep, Period> ttl) noexcept requires expiry_state_t::enabled {
+    expiry.set_negative_time_to_live(std::chrono::duration_cast<typename expiry_t::resolution>(ttl));
+  }
+
+  /// Insert a negative entry: a key that is known to have no value. Negative entries are not found (nor contained), but
+  /// make `find_or_insert_optional` return no value without calling the function. They only store the key (the value
+  /// storage of the slot is left empty), and are replaced by inserting a value for the key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// c.insert_negative("hello");
+  ///
+  /// assert(!c.contains("hello"));
+  /// assert(c.contains_negative("hello"));
+  /// ```
+  template<typename Key_>
+  constexpr void insert_negative(Key_&& key) requires (std::assignable_from<Key&, Key_> || std::convertible_to<Key_, Key>) {
+    insert_negative_slot(std::forward<Key_>(key));
+  }
+
+  /// Insert a negative entry that expires after `ttl`, rather than the (negative) cache time to live.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4, mc::expiry::ttl<>> c;
+  ///
+  /// c.insert_negative("hello", std::chrono::seconds{10});
+  ///
+  /// assert(c.contains_negative("hello"));
+  /// ```
+  template<typename Key_, typename Rep, typename Period>
+  void insert_negative(Key_&& key, std::chrono::duration<Rep, Period> ttl) requires expiry_state_t::enabled
+                                                                          && (std::assignable_from<Key&, Key_> || std::convertible_to<Key_, Key>)
+  {
+    if (const auto i = insert_negative_slot(std::forward<Key_>(key)); i != Size) {
+      expiry.stamp(i, std::chrono::duration_cast<typename expiry_t::resolution>(ttl));
+    }
+  }
+
+  /// Insert a value constructed in place from `args`, unless the key already exists in the cache. Returns a reference to
+  /// the found or newly inserted value, and whether it was inserted. The arguments are left untouched if the key exists.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, std::string, 4> c;
+  ///
+  /// auto [v, inserted] = c.try_emplace(42, 3, 'x');
+  ///
+  /// assert(inserted);
+  /// assert(v == "xxx");
+  ///
+  /// assert(!c.try_emplace(42, "The Answer").second);
+  /// assert(c.find(42).value() == "xxx");
+  /// ```
+  template<typename Key_, typename... Args>
+  constexpr std::pair<Val&, bool> try_emplace(Key_&& key, Args&&... args) requires (std::assignable_from<Key&, Key_> || std::convertible_to<Key_, Key>)
+                                                                      && std::constructible_from<Val, Args...>
+  {
+    if (const auto i = lookup_slot(key); i != Size) {
+      if (expiry.live(i) && !buffer.is_negative(i)) {
+        on_hit(i);
+        return {buffer.value(i), false};
+      }
+
+      return {refill(i, std::forward<Args>(args)...), true};
+    }
+
+    return {replace_and_shift(std::forward<Key_>(key), std::forward<Args>(args)...), true};
+  }
+
+  /// Insert a value constructed in place from `args`, replacing the value if the key already exists in the cache. Returns
+  /// a reference to the new value, and whether it was inserted (rather than replaced). Like `try_emplace`, counted as a
+  /// lookup by `mc::stats::counters` (a hit if the key existed).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, std::string, 4> c;
+  ///
+  /// assert(c.emplace_or_assign(42, 3, 'x').second);
+  /// assert(!c.emplace_or_assign(42, "The Answer").second);
+  /// assert(c.find(42).value() == "The Answer");
+  /// ```
+  template<typename Key_, typename... Args>
+  constexpr std::pair<Val&, bool> emplace_or_assign(Key_&& key, Args&&... args) requires (std::assignable_from<Key&, Key_> || std::convertible_to<Key_, Key>)
+                                                                            && std::constructible_from<Val, Args...>
+  {
+    if (const auto i = lookup_slot(key); i != Size) {
+      const bool replaced = expiry.live(i) && !buffer.is_negative(i);
+      return {refill(i, std::forward<Args>(args)...), !replaced};
+    }
+
+    return {replace_and_shift(std::forward<Key_>(key), std::forward<Args>(args)...), true};
+  }
+
+  /// Lookup a cache entry by key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// assert(!c.find("hello").has_value());
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").has_value());
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  [[nodiscard]] constexpr std::optional<std::reference_wrapper<Val>> find(const Key& key) {
+    return as_optional_ref(find_impl(key));
+  }
+
+  /// Lookup a cache entry by a key of another type that compares with `Key` (e.g. a `std::string_view` or string literal
+  /// for `std::string` keys), without constructing a `Key`.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find(std::string_view{"hello"}).value() == 42);
+  /// ```
+  template<typename K>
+    requires detail::lookup_key_for<K, Key>
+  [[nodiscard]] constexpr std::optional<std::reference_wrapper<Val>> find(const K& key) {
+    return as_optional_ref(find_impl(key));
+  }
+
+  /// Lookup a cache entry by key, without counting it as a hit for the eviction policy (a peek).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// const auto& cc = c;
+  ///
+  /// assert(cc.find("hello").value() == 42);
+  /// ```
+  [[nodiscard]] constexpr std::optional<std::reference_wrapper<const Val>> find(const Key& key) const {
+    return as_optional_ref(find_impl(key));
+  }
+
+  /// Lookup a cache entry by a key of another type that compares with `Key`, without counting it as a hit for the eviction
+  /// policy (a peek).
+  template<typename K>
+    requires detail::lookup_key_for<K, Key>
+  [[nodiscard]] constexpr std::optional<std::reference_wrapper<const Val>> find(const K& key) const {
+    return as_optional_ref(find_impl(key));
+  }
+
+  /// Lookup a cache entry by key. Returns a pointer to the value, or `nullptr` if the key does not exist in the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// assert(c.find_ptr("hello") == nullptr);
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// if (auto* v = c.find_ptr("hello")) {
+  ///   assert(*v == 42);
+  /// }
+  /// ```
+  [[nodiscard]] constexpr Val* find_ptr(const Key& key) {
+    return find_impl(key);
+  }
+
+  /// Lookup a cache entry by a key of another type that compares with `Key`. Returns a pointer to the value, or `nullptr`
+  /// if the key does not exist in the cache.
+  template<typename K>
+    requires detail::lookup_key_for<K, Key>
+  [[nodiscard]] constexpr Val* find_ptr(const K& key) {
+    return find_impl(key);
+  }
+
+  /// Lookup a cache entry by key, without counting it as a hit for the eviction policy (a peek). Returns a pointer to the
+  /// value, or `nullptr` if the key does not exist in the cache.
+  [[nodiscard]] constexpr const Val* find_ptr(const Key& key) const {
+    return find_impl(key);
+  }
+
+  /// Lookup a cache entry by a key of another type that compares with `Key`, without counting it as a hit for the eviction
+  /// policy (a peek). Returns a pointer to the value, or `nullptr` if the key does not exist in the cache.
+  template<typename K>
+    requires detail::lookup_key_for<K, Key>
+  [[nodiscard]] constexpr const Val* find_ptr(const K& key) const {
+    return find_impl(key);
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`.
+  /// Returns a reference to the found, or newly inserted value associated with the given key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, std::string, 4> c;
+  ///
+  /// assert(!c.contains(42));
+  ///
+  /// auto v = c.find_or_insert_with(42, [] { return "The Answer"; });
+  ///
+  /// assert(v == "The Answer");
+  /// assert(c.find(42).has_value());
+  /// assert(c.find(42).value() == "The Answer");
+  /// ```
+  template<typename F>
+  [[nodiscard]] constexpr std::reference_wrapper<Val> find_or_insert_with(const Key& key, F f) {
+    if (const auto i = lookup_slot(key); i != Size) {
+      if (expiry.live(i) && !buffer.is_negative(i)) {
+        on_hit(i);
+        return buffer.value(i);
+      }
+
+      return refill(i, f(key));
+    }
+
+    return replace_and_shift(key, f(key));
+  }
+
+  /// Get a value by a key of another type that compares with `Key`, or, if it does not exist in the cache, insert it using
+  /// the value computed by `f`. A `Key` is only constructed (and passed to `f`) when inserting.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, std::size_t, 4> c;
+  ///
+  /// auto v = c.find_or_insert_with(std::string_view{"hello"}, [](const std::string& k) { return k.size(); });
+  ///
+  /// assert(v == 5);
+  /// assert(c.contains("hello"));
+  /// ```
+  template<typename K, typename F>
+    requires detail::lookup_key_for<K, Key> && std::constructible_from<Key, const K&>
+  [[nodiscard]] constexpr std::reference_wrapper<Val> find_or_insert_with(const K& key, F f) {
+    if (const auto i = lookup_slot(key); i != Size) {
+      if (expiry.live(i) && !buffer.is_negative(i)) {
+        on_hit(i);
+        return buffer.value(i);
+      }
+
+      // SAFETY: The slot key is equal to `key`, and the slot is occupied by definition.
+      return refill(i, f(std::as_const(buffer.key(i))));
+    }
+
+    Key k(key);
+    auto val = f(std::as_const(k));
+
+    return replace_and_shift(std::move(k), std::move(val));
+  }
+
+  /// Get the value for a key, or, if it does not exist in the cache, compute it using `f` (returning a `std::optional`),
+  /// and insert it. If `f` returns no value, a negative entry is inserted instead, so that `f` is not called again for the
+  /// key until the entry is evicted (or expires).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, int, 4> c;
+  ///
+  /// int calls = 0;
+  /// const auto even_half = [&calls](int k) -> std::optional<int> {
+  ///   ++calls;
+  ///   return (k % 2 == 0) ? std::optional{k / 2} : std::nullopt;
+  /// };
+  ///
+  /// assert(c.find_or_insert_optional(42, even_half)->get() == 21);
+  /// assert(!c.find_or_insert_optional(17, even_half).has_value());
+  /// assert(!c.find_or_insert_optional(17, even_half).has_value());
+  /// assert(calls == 2);
+  /// ```
+  template<typename F>
+    requires std::convertible_to<std::invoke_result_t<F&, const Key&>, std::optional<Val>>
+  [[nodiscard]] constexpr std::optional<std::reference_wrapper<Val>> find_or_insert_optional(const Key& key, F f) {
+    const auto i = lookup_slot(key);
+
+    if (i != Size && expiry.live(i)) {
+      on_hit(i);
+      return buffer.is_negative(i) ? std::nullopt : std::optional{std::ref(buffer.value(i))};
+    }
+
+    std::optional<Val> val = f(key);
+
+    if (!val) {
+      if (i != Size) {
+        refill_negative(i);
+      } else {
+        replace_and_shift_slot(nullptr, key, detail::no_value_t{});
+      }
+
+      return std::nullopt;
+    }
+
+    return std::ref((i != Size) ? refill(i, std::move(*val)) : replace_and_shift(key, std::move(*val)));
+  }
+
+  /// Lookup a batch of cache entries by key. Stores a pointer to the value of each key in `out` (at the same position),
+  /// or `nullptr` if the key does not exist in the cache. Returns the number of keys found.
+  ///
+  /// SAFETY: `out` must hold at least as many elements as `keys`. The pointers are invalidated by any insertion.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <array>
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, float, 4> c;
+  ///
+  /// c.insert(17, 42);
+  ///
+  /// const std::array keys{17, 23};
+  /// std::array<float*, 2> out;
+  ///
+  /// assert(c.find_many(keys, out) == 1);
+  /// assert(*out[0] == 42 && out[1] == nullptr);
+  /// ```
+  constexpr std::size_t find_many(std::span<const Key> keys, std::span<Val*> out) {
+    std::size_t hits{};
+
+    // NOTE: The keys are looked up back to back, so that the cache keys (and metadata) stay hot in the L1 cache.
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = find_impl(keys[i]);
+      hits += (out[i] != nullptr);
+    }
+
+    return hits;
+  }
+
+  /// Get a batch of values, computing those that do not exist in the cache at once. Stores (a copy of) the value of each
+  /// key in `out` (at the same position).
+  ///
+  /// The missing keys are passed to `f` in a single call as a `std::span<const Key>` of distinct keys (in order of first
+  /// occurrence), along with a `std::span<Val>` of equal size to store their values in. `f` is not called if all keys are
+  /// found. The computed values are then inserted (in order), so that a batch with more misses than the cache size keeps
+  /// the last of them.
+  ///
+  /// SAFETY: `out` must hold at least as many elements as `keys`.
+  ///
+  /// NOTE: Allocates temporary storage for the missing keys and their values, if there are any. The missing keys are
+  ///       deduplicated in `O(M log M)` time if they are totally ordered, and in `O(M^2)` time otherwise.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <array>
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, int, 4> c;
+  ///
+  /// c.insert(17, 34);
+  ///
+  /// const std::array keys{17, 23, 23};
+  /// std::array<int, 3> out;
+  ///
+  /// c.find_or_insert_many(keys, out, [](std::span<const int> misses, std::span<int> vals) {
+  ///   assert(misses.size() == 1); // Only 23.
+  ///
+  ///   for (std::size_t i = 0; i < misses.size(); ++i) {
+  ///     vals[i] = misses[i] * 2;
+  ///   }
+  /// });
+  ///
+  /// assert(out[0] == 34 && out[1] == 46 && out[2] == 46);
+  /// ```
+  template<typename F>
+    requires std::invocable<F&, std::span<const Key>, std::span<Val>> && std::default_initializable<Val> && std::copyable<Val>
+  constexpr void find_or_insert_many(std::span<const Key> keys, std::span<Val> out, F f) {
+    std::vector<Key>                                  misses;
+    std::vector<std::pair<std::size_t, std::size_t>> positions; // Of the missing keys in `keys` and in `misses`.
+
+    // NOTE: Missing keys may still be resident (expired or negative), and must not be inserted twice.
+    bool resident = expiry_state_t::enabled;
+
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      if (const auto slot = find_live(keys[i]); slot != Size && !buffer.is_negative(slot)) {
+        on_hit(slot);
+        out[i] = buffer.value(slot);
+      } else {
+        resident |= (slot != Size);
+        positions.emplace_back(i, Size);
+      }
+    }
+
+    if (positions.empty()) {
+      return;
+    }
+
+    if constexpr (std::totally_ordered<Key>) {
+      // NOTE: The positions are sorted by key (and position), so that every position can point to the first position
+      //       of its key. The first positions then take the next index in `misses`, in order, and the others its index.
+      std::vector<std::size_t> order(positions.size());
+      for (std::size_t p = 0; p < order.size(); ++p) {
+        order[p] = p;
+      }
+
+      std::ranges::sort(order, [&](std::size_t a, std::size_t b) {
+        const auto& x = keys[positions[a].first];
+        const auto& y = keys[positions[b].first];
+        return x < y || (!(y < x) && a < b);
+      });
+
+      for (std::size_t j = 0, first = 0; j < order.size(); ++j) {
+        if (keys[positions[order[j]].first] != keys[positions[order[first]].first]) {
+          first = j;
+        }
+
+        positions[order[j]].second = order[first];
+      }
+
+      for (std::size_t p = 0; p < positions.size(); ++p) {
+        auto& [i, m] = positions[p];
+
+        if (m == p) {
+          m = misses.size();
+          misses.push_back(keys[i]);
+        } else {
+          m = positions[m].second;
+        }
+      }
+    } else {
+      for (auto& [i, m] : positions) {
+        m = static_cast<std::size_t>(std::distance(misses.begin(), std::ranges::find(misses, keys[i])));
+        if (m == misses.size()) {
+          misses.push_back(keys[i]);
+        }
+      }
+    }
+
+    std::vector<Val> vals(misses.size());
+    f(std::span<const Key>{misses}, std::span<Val>{vals});
+
+    for (const auto& [i, m] : positions) {
+      out[i] = vals[m];
+    }
+
+    for (std::size_t m = 0; m < misses.size(); ++m) {
+      if (resident) {
+        upsert(std::move(misses[m]), std::move(vals[m]));
+      } else {
+        replace_and_shift(std::move(misses[m]), std::move(vals[m]));
+      }
+    }
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, std::string, 4> c;
+  ///
+  /// assert(!c.contains(42));
+  ///
+  /// c.insert(42, "The Answer");
+  ///
+  /// assert(c.contains(42));
+  /// ```
+  [[nodiscard]] constexpr bool contains(const Key& key) const {
+    const auto i = find_live(key);
+    return i != Size && !buffer.is_negative(i);
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key of another type that compares with `Key`, without
+  /// constructing a `Key`.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.contains(std::string_view{"hello"}));
+  /// ```
+  template<typename K>
+    requires detail::lookup_key_for<K, Key>
+  [[nodiscard]] constexpr bool contains(const K& key) const {
+    const auto i = find_live(key);
+    return i != Size && !buffer.is_negative(i);
+  }
+
+  /// Returns `true` if the cache contains a negative entry for the specified key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, std::string, 4> c;
+  ///
+  /// c.insert_negative(42);
+  ///
+  /// assert(c.contains_negative(42));
+  ///
+  /// c.insert(42, "The Answer");
+  ///
+  /// assert(!c.contains_negative(42));
+  /// ```
+  [[nodiscard]] constexpr bool contains_negative(const Key& key) const {
+    const auto i = find_live(key);
+    return i != Size && buffer.is_negative(i);
+  }
+
+  /// Returns `true` if the cache contains a negative entry for a key of another type that compares with `Key`.
+  template<typename K>
+    requires detail::lookup_key_for<K, Key>
+  [[nodiscard]] constexpr bool contains_negative(const K& key) const {
+    const auto i = find_live(key);
+    return i != Size && buffer.is_negative(i);
+  }
+
+  /// Get the statistics counted so far.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4, mc::stats::counters> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.contains("hello"));
+  /// assert(c.statistics().hits == 1);
+  /// ```
+  [[nodiscard]] cache_stats statistics() const noexcept requires stats_state_t::enabled {
+    return stats.load();
+  }
+
+  /// Reset the statistics counters to zero.
+  void reset_statistics() noexcept requires stats_state_t::enabled {
+    stats.reset();
+  }
+
+  /// Set a function to call with the key and value of every entry about to be evicted (replaced by an insert).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, float, 1, mc::stats::counters> c;
+  ///
+  /// int evicted = 0;
+  /// c.set_eviction_hook([&evicted](const int& k, const float&) { evicted = k; });
+  ///
+  /// c.insert(17, 42);
+  /// c.insert(23, 42);
+  ///
+  /// assert(evicted == 17);
+  /// ```
+  void set_eviction_hook(std::function<void(const Key&, const Val&)> hook) requires stats_state_t::enabled {
+    stats.set_eviction_hook(std::move(hook));
+  }
+
+  /// Call `f` with the key and value of every live entry, in slot order. Not counted as lookups.
+  ///
+  /// Serves as the streaming serialization hook for caches of types that cannot be saved as a raw image: write the entries
+  /// out in any format, and warm-start a cache later by inserting them again.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// float sum = 0;
+  /// c.for_each([&sum](const std::string&, const float& v) { sum += v; });
+  ///
+  /// assert(sum == 42);
+  /// ```
+  template<typename F>
+    requires std::is_invocable_v<F&, const Key&, const Val&>
+  constexpr void for_each(F f) const {
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (buffer.is_occupied(i) && expiry.live(i) && !buffer.is_negative(i)) {
+        std::invoke(f, buffer.key(i), buffer.value(i));
+      }
+    }
+  }
+
+  /// Save a snapshot of the cache to the file at `path`. Returns `false` if the file could not be written.
+  ///
+  /// The snapshot is a versioned binary image: a 64 byte header, followed by the raw slot buffer (keys, values and
+  /// occupancy) and the eviction policy state. It can be memory-mapped and passed to `load` as is, so a cache can be
+  /// warm-started without parsing. Available for trivially copyable keys and values, without entry expiry.
+  ///
+  /// NOTE: The image is only meaningful to a cache of the same type, built by the same compiler and options; the header
+  ///       detects most mismatches. Pointer keys or values are saved as is.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<int, float, 4> c;
+  ///
+  /// c.insert(17, 42);
+  ///
+  /// assert(c.save("cache.bin"));
+  ///
+  /// memo_cache<int, float, 4> d;
+  ///
+  /// assert(d.load("cache.bin"));
+  /// assert(d.find(17).value() == 42);
+  /// ```
+  [[nodiscard]] bool save(const std::filesystem::path& path) const requires SNAPSHOTS {
+    const auto header = expected_header();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&buffer), sizeof(buffer));
+    out.write(reinterpret_cast<const char*>(&eviction), sizeof(eviction));
+    out.flush();
+
+    return out.good();
+  }
+
+  /// Load a snapshot saved by `save` from the file at `path`. Returns `false`, leaving the cache unchanged, if the file
+  /// could not be read or does not hold a snapshot for this cache type.
+  [[nodiscard]] bool load(const std::filesystem::path& path) requires SNAPSHOTS {
+    std::ifstream in(path, std::ios::binary);
+
+    std::vector<std::byte> image(SNAPSHOT_SIZE);
+    in.read(reinterpret_cast<char*>(image.data()), static_cast<std::streamsize>(image.size()));
+
+    // Reject truncated files, as well as trailing data.
+    if (!in || in.peek() != std::ifstream::traits_type::eof()) {
+      return false;
+    }
+
+    return load(std::span<const std::byte>{image});
+  }
+
+  /// Load a snapshot image saved by `save`, e.g. from a memory-mapped file. Returns `false`, leaving the cache unchanged,
+  /// if `image` does not hold a snapshot for this cache type, or its buffer and eviction state are inconsistent.
+  [[nodiscard]] bool load(std::span<const std::byte> image) requires SNAPSHOTS {
+    detail::snapshot_header header;
+
+    if (image.size() != SNAPSHOT_SIZE) {
+      return false;
+    }
+
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    if (header != expected_header()) {
+      return false;
+    }
+
+    // NOTE: The image is staged on the heap (the buffer may be large), and validated before it replaces the cache state,
+    //       so that a corrupted image is rejected rather than indexing out of bounds later on.
+    auto staged_buffer   = std::make_unique_for_overwrite<buffer_t>();
+    auto staged_eviction = std::make_unique_for_overwrite<typename policy_t::template state<Size>>();
+
+    // SAFETY: The buffer and eviction state are trivially copyable, and the header matched the layout of this cache type.
+    std::memcpy(staged_buffer.get(), image.data() + sizeof(header), sizeof(buffer));
+    std::memcpy(staged_eviction.get(), image.data() + sizeof(header) + sizeof(buffer), sizeof(eviction));
+
+    if (!staged_buffer->valid()) {
+      return false;
+    }
+
+    detail::bitmask<Size> occupied;
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (staged_buffer->is_occupied(i)) {
+        occupied.set(i);
+      }
+    }
+
+    if (!staged_eviction->valid(occupied)) {
+      return false;
+    }
+
+    buffer   = *staged_buffer;
+    eviction = *staged_eviction;
+    probe.clear();
+
+    return true;
+  }
+
+  /// Clear the cache.
+  ///
+  /// Only marks the slots unoccupied, without destroying the keys and values: they are replaced when their slots are
+  /// filled again. Use `purge` to destroy them (e.g. to release the memory they own).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, float, 4> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").has_value());
+  /// assert(c.find("hello").value() == 42);
+  ///
+  /// c.clear();
+  ///
+  /// assert(!c.find("hello").has_value());
+  /// ```
+  constexpr void clear() {
+    buffer.clear();
+    eviction.clear();
+    expiry.clear();
+    admission.clear();
+    probe.clear();
+  }
+
+  /// Clear the cache, and destroy all values, releasing the memory they own. Keys are destroyed too (with the `aos` and
+  /// `aligned` layouts), or reset to default-constructed ones (with the `soa` and `fingerprinted` layouts, that keep all
+  /// keys live for dense scans).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// memo_cache<std::string, std::string, 4> c;
+  ///
+  /// c.insert("hello", std::string(1000, 'x'));
+  /// c.purge();
+  ///
+  /// assert(!c.contains("hello"));
+  /// ```
+  constexpr void purge() {
+    clear();
+    buffer.purge();
+  }
+};
+
+///
+/// A fixed-size key/value cache with FIFO retention management, indexed by a hash table for constant time lookup.
+///
+/// Entries are stored in a preallocated ring (just like `memo_cache`), and located through an open addressing index of
+/// Swiss table style control bytes (compared 16 at a time). The index is sized for a maximum load factor of 80%, and
+/// uses linear probing with backward shift deletion, so it never degrades from evictions and never allocates.
+///
+/// NOTE: All storage is inline; large caches should have static storage duration, or be allocated on the heap.
+///
+template<std::regular Key, std::regular Val, std::size_t Size, typename Hash = std::hash<Key>>
+  requires std::is_invocable_r_v<std::size_t, const Hash&, const Key&>
+class indexed_memo_cache {
+  static_assert(Size > 0);
+  static_assert(Size <= (std::size_t{1} << 24), "Semantic constraint: all storage is inline, use a runtime-sized cache instead.");
+
+  static constexpr std::size_t GROUP    = 16;
+  static constexpr std::size_t CAPACITY = std::max(GROUP, std::bit_ceil(Size + (Size / 4)));
+  static constexpr std::size_t MASK     = CAPACITY - 1;
+
+  static constexpr std::uint8_t EMPTY = 0x80;
+
+  using slot_index_t = detail::index_t<Size>;
+
+  struct slot_t {
+    Key              key{};
+    std::optional<Val> val;
+    std::uint32_t    home{}; // Hash bits selecting the home position in the index.
+  };
+
+  std::array<slot_t, Size> ring;
+  std::size_t cursor{};
+
+  // The control bytes hold either `EMPTY`, or the low 7 hash bits of the slot referred to by the same index position.
+  // The first group is mirrored past the end, so that every position can be the start of an (unaligned) group.
+  std::array<std::uint8_t, CAPACITY + GROUP> ctrl;
+  std::array<slot_index_t, CAPACITY> index{};
+
+  [[no_unique_address]] Hash hasher;
+
+  [[nodiscard]] std::uint64_t hash_of(const Key& key) const {
+    return detail::mix_hash(static_cast<std::uint64_t>(hasher(key)));
+  }
+
+  static constexpr std::uint8_t h2(std::uint64_t h) noexcept {
+    return static_cast<std::uint8_t>(h & 0x7F);
+  }
+
+  static constexpr std::uint32_t h1(std::uint64_t h) noexcept {
+    return static_cast<std::uint32_t>(h >> 7);
+  }
+
+  void set_ctrl(std::size_t pos, std::uint8_t c) noexcept {
+    ctrl[pos] = c;
+    if (pos < GROUP) {
+      ctrl[CAPACITY + pos] = c;
+    }
+  }
+
+  /// Returns the index position referring to the slot holding `key`, or `CAPACITY` if there is none.
+  [[nodiscard]] std::size_t find_position(const Key& key) const {
+    const auto h = hash_of(key);
+
+    for (std::size_t pos = h1(h) & MASK;; pos = (pos + GROUP) & MASK) {
+      const auto empty = detail::match_keys(ctrl.data() + pos, GROUP, EMPTY);
+
+      // Linear probing: the key cannot be located beyond the first empty position.
+      auto candidates = detail::match_keys(ctrl.data() + pos, GROUP, h2(h)) & ((empty & (~empty + 1)) - 1);
+
+      for (; candidates != 0; candidates &= candidates - 1) {
+        const auto p = (pos + static_cast<std::size_t>(std::countr_zero(candidates))) & MASK;
+        if (ring[index[p]].key == key) {
+          return p;
+        }
+      }
+
+      if (empty != 0) {
+        return CAPACITY;
+      }
+    }
+  }
+
+  /// Remove the index position referring to the occupied slot `s`, shifting back the entries probed past it.
+  void erase_position(std::size_t s) noexcept {
+    auto hole = static_cast<std::size_t>(ring[s].home) & MASK;
+    while (index[hole] != s || ctrl[hole] == EMPTY) {
+      hole = (hole + 1) & MASK;
+    }
+
+    for (auto pos = (hole + 1) & MASK; ctrl[pos] != EMPTY; pos = (pos + 1) & MASK) {
+      // Entries whose home lies cyclically in (hole, pos] are still reachable; the others move into the hole.
+      const auto home = static_cast<std::size_t>(ring[index[pos]].home) & MASK;
+      if ((hole <= pos) ? ((hole < home) && (home <= pos)) : ((hole < home) || (home <= pos))) {
+        continue;
+      }
+
+      set_ctrl(hole, ctrl[pos]);
+      index[hole] = index[pos];
+      hole        = pos;
+    }
+
+    set_ctrl(hole, EMPTY);
+  }
+
+  /// Replace slot under cursor and shift cursor position. Returns a reference to the replaced slot value.
+  template<typename Key_, typename Val_>
+  Val& replace_and_shift(Key_&& key, Val_&& val) {
+    auto& slot = ring[cursor];
+    if (slot.val) {
+      erase_position(cursor);
+    }
+
+    slot.key = std::forward<Key_>(key);
+    slot.val = std::forward<Val_>(val);
+
+    const auto h = hash_of(slot.key);
+    slot.home = h1(h);
+
+    auto pos = static_cast<std::size_t>(slot.home) & MASK;
+    while (ctrl[pos] != EMPTY) {
+      pos = (pos + 1) & MASK;
+    }
+
+    set_ctrl(pos, h2(h));
+    index[pos] = static_cast<slot_index_t>(cursor);
+
+    // Move the cursor over the ring elements sequentially, creating FIFO behavior.
+    cursor = (cursor + 1) % Size;
+
+    // SAFETY: The option value is occupied above.
+    return *slot.val;
+  }
+
+public:
+  indexed_memo_cache() {
+    ctrl.fill(EMPTY);
+  }
+
+  /// Get the (fixed) size of the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// indexed_memo_cache<std::string, float, 4096> c;
+  ///
+  /// assert(c.size() == 4096);
+  /// ```
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return Size;
+  }
+
+  /// Insert a key/value pair.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// indexed_memo_cache<std::string, float, 4096> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  template<typename Key_, typename Val_>
+  void insert(Key_&& key, Val_&& val) requires (std::assignable_from<Key, Key_> || std::convertible_to<Key_, Key>)
+                                            && (std::assignable_from<Val, Val_> || std::convertible_to<Val_, Val>)
+  {
+    // Overwrite values for identical keys.
+    if (auto found = find(key); found) {
+      found.value().get() = std::forward<Val_>(val);
+    } else {
+      replace_and_shift(std::forward<Key_>(key), std::forward<Val_>(val));
+    }
+  }
+
+  /// Lookup a cache entry by key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// indexed_memo_cache<std::string, float, 4096> c;
+  ///
+  /// assert(!c.find("hello").has_value());
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  [[nodiscard]] std::optional<std::reference_wrapper<Val>> find(const Key& key) {
+    if (const auto pos = find_position(key); pos != CAPACITY) {
+      // SAFETY: Index positions only refer to occupied slots.
+      return std::ref(*ring[index[pos]].val);
+    }
+
+    return std::nullopt;
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`.
+  /// Returns a reference to the found, or newly inserted value associated with the given key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// indexed_memo_cache<int, std::string, 4096> c;
+  ///
+  /// auto v = c.find_or_insert_with(42, [](int) { return "The Answer"; });
+  ///
+  /// assert(v == "The Answer");
+  /// assert(c.contains(42));
+  /// ```
+  template<typename F>
+  [[nodiscard]] std::reference_wrapper<Val> find_or_insert_with(const Key& key, F f) {
+    if (auto slot = find(key); slot) {
+      return *slot;
+    }
+
+    return replace_and_shift(key, f(key));
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// indexed_memo_cache<int, std::string, 4096> c;
+  ///
+  /// assert(!c.contains(42));
+  ///
+  /// c.insert(42, "The Answer");
+  ///
+  /// assert(c.contains(42));
+  /// ```
+  [[nodiscard]] bool contains(const Key& key) const {
+    return find_position(key) != CAPACITY;
+  }
+
+  /// Clear the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// indexed_memo_cache<std::string, float, 4096> c;
+  ///
+  /// c.insert("hello", 42);
+  /// c.clear();
+  ///
+  /// assert(!c.contains("hello"));
+  /// ```
+  void clear() {
+    // NOTE: The slots are reset in place, as a temporary array of them may not fit on the stack.
+    for (auto& slot : ring) {
+      slot.key = Key{};
+      slot.val.reset();
+      slot.home = 0;
+    }
+
+    ctrl.fill(EMPTY);
+  }
+};
+
+///
+/// A fixed-capacity key/value cache with FIFO retention management, for use with regular types, with the capacity chosen
+/// at runtime and the storage obtained from a `std::pmr::memory_resource`.
+///
+/// Storage is allocated once on construction (keys, occupancy and values in separate arrays, like `mc::layout::soa`), and
+/// never reallocated nor freed before destruction. Lookup is a linear scan over the keys, just like `memo_cache`.
+///
+template<std::regular Key, std::regular Val>
+class dynamic_memo_cache {
+  std::pmr::vector<Key>           keys;
+  std::pmr::vector<std::uint64_t> occupied; // Bitmask words, padded for whole scan blocks.
+  std::pmr::vector<Val>           vals;
+  std::size_t                     cursor{};
+
+  [[nodiscard]] std::size_t find_slot(const Key& key) const {
+    return detail::find_key(keys.data(), occupied.data(), keys.size(), key);
+  }
+
+  /// Replace slot under cursor and shift cursor position. Returns a reference to the replaced slot value.
+  template<typename Key_, typename Val_>
+  Val& replace_and_shift(Key_&& key, Val_&& val) {
+    const auto slot = cursor;
+
+    // NOTE: The slot is only marked occupied once both the key and value are in place.
+    occupied[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+    keys[slot] = std::forward<Key_>(key);
+    vals[slot] = std::forward<Val_>(val);
+    occupied[slot / 64] |= std::uint64_t{1} << (slot % 64);
+
+    // Move the cursor over the slots sequentially, overwriting the oldest element next time around.
+    cursor = (cursor + 1) % keys.size();
+
+    return vals[slot];
+  }
+
+public:
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  /// Create a cache of `capacity` (at least one) entries, with storage from `resource`.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <array>
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  /// #include <memory_resource>
+  ///
+  /// std::array<std::byte, 4096> arena;
+  /// std::pmr::monotonic_buffer_resource resource{arena.data(), arena.size()};
+  ///
+  /// dynamic_memo_cache<int, float> c{64, &resource};
+  ///
+  /// assert(c.size() == 64);
+  /// ```
+  explicit dynamic_memo_cache(std::size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : keys(std::max(capacity, std::size_t{1}), resource)
+    , occupied((keys.size() + 63) / 64, resource)
+    , vals(keys.size(), resource) {}
+
+  /// Create a cache of `capacity` (at least one) entries, with storage from `alloc`.
+  dynamic_memo_cache(std::size_t capacity, const allocator_type& alloc) : dynamic_memo_cache(capacity, alloc.resource()) {}
+
+  /// Get the allocator of the cache storage.
+  [[nodiscard]] allocator_type get_allocator() const noexcept {
+    return keys.get_allocator();
+  }
+
+  /// Get the (fixed) size of the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<std::string, float> c{4};
+  ///
+  /// assert(c.size() == 4);
+  /// ```
+  [[nodiscard]] std::size_t size() const noexcept {
+    return keys.size();
+  }
+
+  /// Insert a key/value pair.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<std::string, float> c{4};
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  template<typename Key_, typename Val_>
+  void insert(Key_&& key, Val_&& val) requires (std::assignable_from<Key&, Key_> || std::convertible_to<Key_, Key>)
+                                            && (std::assignable_from<Val&, Val_> || std::convertible_to<Val_, Val>)
+  {
+    // Overwrite values for identical keys.
+    if (auto* found = find_ptr(key)) {
+      *found = std::forward<Val_>(val);
+    } else {
+      replace_and_shift(std::forward<Key_>(key), std::forward<Val_>(val));
+    }
+  }
+
+  /// Lookup a cache entry by key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<std::string, float> c{4};
+  ///
+  /// assert(!c.find("hello").has_value());
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  [[nodiscard]] std::optional<std::reference_wrapper<Val>> find(const Key& key) {
+    if (auto* found = find_ptr(key)) {
+      return std::ref(*found);
+    }
+
+    return std::nullopt;
+  }
+
+  /// Lookup a cache entry by key. Returns a pointer to the value, or `nullptr` if the key does not exist in the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<std::string, float> c{4};
+  ///
+  /// assert(c.find_ptr("hello") == nullptr);
+  /// ```
+  [[nodiscard]] Val* find_ptr(const Key& key) {
+    const auto i = find_slot(key);
+    return (i != keys.size()) ? &vals[i] : nullptr;
+  }
+
+  [[nodiscard]] const Val* find_ptr(const Key& key) const {
+    const auto i = find_slot(key);
+    return (i != keys.size()) ? &vals[i] : nullptr;
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`.
+  /// Returns a reference to the found, or newly inserted value associated with the given key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<int, std::string> c{4};
+  ///
+  /// auto v = c.find_or_insert_with(42, [](int) { return "The Answer"; });
+  ///
+  /// assert(v == "The Answer");
+  /// assert(c.contains(42));
+  /// ```
+  template<typename F>
+  [[nodiscard]] std::reference_wrapper<Val> find_or_insert_with(const Key& key, F f) {
+    if (auto* found = find_ptr(key)) {
+      return *found;
+    }
+
+    return replace_and_shift(key, f(key));
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<int, std::string> c{4};
+  ///
+  /// c.insert(42, "The Answer");
+  ///
+  /// assert(c.contains(42));
+  /// ```
+  [[nodiscard]] bool contains(const Key& key) const {
+    return find_slot(key) != keys.size();
+  }
+
+  /// Clear the cache. Keeps the storage.
+  ///
+  /// Only marks the slots unoccupied, without destroying the keys and values: they are replaced when their slots are
+  /// filled again. Use `purge` to destroy them (e.g. to release the memory they own).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// dynamic_memo_cache<std::string, float> c{4};
+  ///
+  /// c.insert("hello", 42);
+  /// c.clear();
+  ///
+  /// assert(!c.contains("hello"));
+  /// ```
+  void clear() {
+    std::ranges::fill(occupied, std::uint64_t{});
+    cursor = 0;
+  }
+
+  /// Clear the cache, and reset all keys and values to default-constructed ones. Keeps the storage.
+  void purge() {
+    clear();
+    std::ranges::fill(keys, Key{});
+    std::ranges::fill(vals, Val{});
+  }
+};
+
+namespace detail {
+
+/// Hint the processor that the calling thread is busy-waiting.
+inline void cpu_relax() noexcept {
+#if defined(MC_SIMD_SSE2)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+/// A test-and-test-and-set spin lock, for (very) short critical sections.
+class spin_lock {
+  std::atomic<bool> locked{false};
+
+public:
+  void lock() noexcept {
+    for (unsigned spins = 0; locked.exchange(true, std::memory_order_acquire); ++spins) {
+      while (locked.load(std::memory_order_relaxed)) {
+        if (spins < 64) {
+          cpu_relax();
+          ++spins;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] bool try_lock() noexcept {
+    return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+  }
+
+  void unlock() noexcept {
+    locked.store(false, std::memory_order_release);
+  }
+};
+
+/// The `Options` not deriving from `Kind`, as `std::tuple`.
+template<typename Kind, typename Kept, typename... Options>
+struct without_options {
+  using type = Kept;
+};
+
+template<typename Kind, typename... Kept, typename Option, typename... Options>
+struct without_options<Kind, std::tuple<Kept...>, Option, Options...>
+    : without_options<Kind, std::conditional_t<std::derived_from<Option, Kind>, std::tuple<Kept...>, std::tuple<Kept..., Option>>, Options...> {};
+
+template<typename Kind, typename... Options>
+using without_options_t = typename without_options<Kind, std::tuple<>, Options...>::type;
+
+/// The `memo_cache` type with the options in the given `std::tuple`.
+template<typename Key, typename Val, std::size_t Size, typename OptionTuple>
+struct memo_cache_with;
+
+template<typename Key, typename Val, std::size_t Size, typename... Options>
+struct memo_cache_with<Key, Val, Size, std::tuple<Options...>> {
+  using type = memo_cache<Key, Val, Size, Options...>;
+};
+
+} // namespace detail
+
+/// Shard locks for concurrent caches, to be passed as cache option (e.g. `concurrent_memo_cache<int, float, 1024, 16, mc::lock::shared>`).
+namespace lock {
+
+/// A spin lock, taken for every operation. This is the default.
+struct spin : detail::lock_option {
+  using type = detail::spin_lock;
+};
+
+/// A reader-writer lock (`std::shared_mutex`). Lookups only take a shared lock if the eviction policy does not track hits
+/// (i.e. `mc::policy::fifo`), and there is neither an admission filter (which counts the accesses of hits too) nor a probe
+/// order that records hits (i.e. `mc::probe::recent`).
+struct shared : detail::lock_option {
+  using type = std::shared_mutex;
+};
+
+} // namespace lock
+
+///
+/// A thread-safe, fixed-size key/value cache with retention management, sharded over independently locked `memo_cache`s.
+///
+/// Keys are hashed (using `std::hash<Key>`) to one of `Shards` shards, each of which holds `Size / Shards` slots and has
+/// its own lock. Every shard is padded to its own cache line(s), so that operations on different shards do not contend.
+/// Values are returned by copy, because references would not be protected by the lock.
+///
+/// All `memo_cache` options apply to the shards, with the addition of the lock option:
+///
+///   - `mc::lock::spin` (default) or `mc::lock::shared`: the shard lock.
+///
+/// NOTE: All storage is inline; large caches should have static storage duration, or be allocated on the heap.
+///
+template<std::regular Key, std::regular Val, std::size_t Size, std::size_t Shards, typename... Options>
+class concurrent_memo_cache {
+  static_assert(Shards > 0);
+  static_assert(Size % Shards == 0, "The cache size must be a multiple of the number of shards.");
+
+  using lock_t  = typename detail::select_option_t<detail::lock_option, lock::spin, Options...>::type;
+  using cache_t = typename detail::memo_cache_with<Key, Val, Size / Shards, detail::without_options_t<detail::lock_option, Options...>>::type;
+
+  static constexpr bool TRACKS_HITS = detail::select_option_t<detail::eviction_option, policy::fifo, Options...>::template state<Size / Shards>::tracks_hits;
+  static constexpr bool COUNTS_ACCESSES = detail::select_option_t<detail::admission_option, admission::always, Options...>::template state<Size / Shards>::enabled;
+  static constexpr bool RECORDS_PROBES  = detail::select_option_t<detail::probe_option, probe::linear, Options...>::template state<Size / Shards>::enabled;
+  static constexpr bool COUNTS_STATS = detail::select_option_t<detail::stats_option, stats::none, Options...>::template state<Key, Val>::enabled;
+
+  /// A value being computed by a (leader) thread in `find_or_insert_with`, which other threads missing on the same key
+  /// wait for. All members but `done` are guarded by the shard lock; the outcome is immutable once `done` is set.
+  struct flight_t {
+    std::optional<Key>         key;    // Engaged while the flight is in use.
+    std::size_t                refs{}; // Leader and waiters.
+    std::atomic<std::uint32_t> done{};
+    std::optional<Val>         val;
+    std::exception_ptr         error;
+  };
+
+  static constexpr std::size_t FLIGHTS = 8; // Per shard; more concurrent misses compute their values independently.
+
+  struct alignas(detail::cache_line_size) shard_t {
+    mutable lock_t lock;
+    cache_t        cache;
+    std::array<flight_t, FLIGHTS> flights;
+  };
+
+  std::array<shard_t, Shards> shards;
+
+  [[nodiscard]] shard_t& shard_for(const Key& key) const {
+    const auto h = detail::mix_hash(static_cast<std::uint64_t>(std::hash<Key>{}(key)));
+
+    // NOTE: The shards are mutable through const member functions, just like their locks.
+    return const_cast<shard_t&>(shards[static_cast<std::size_t>(h % Shards)]);
+  }
+
+  /// Lock a shard for a lookup: shared if possible, exclusive otherwise.
+  [[nodiscard]] static auto lock_for_lookup(shard_t& shard) {
+    // NOTE: Hits write the eviction state of policies that track them, the frequency sketch of admission filters, and the
+    //       last hit of probe orders that record it.
+    if constexpr (requires { shard.lock.lock_shared(); } && !TRACKS_HITS && !COUNTS_ACCESSES && !RECORDS_PROBES) {
+      return std::shared_lock{shard.lock};
+    } else {
+      return std::unique_lock{shard.lock};
+    }
+  }
+
+public:
+  /// Get the (fixed) size of the cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<std::string, float, 64, 8> c;
+  ///
+  /// assert(c.size() == 64);
+  /// ```
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return Size;
+  }
+
+  /// Insert a key/value pair.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<std::string, float, 64, 8> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  template<typename Key_, typename Val_>
+  void insert(Key_&& key, Val_&& val) requires (std::assignable_from<Key, Key_> || std::convertible_to<Key_, Key>)
+                                            && (std::assignable_from<Val, Val_> || std::convertible_to<Val_, Val>)
+  {
+    Key k(std::forward<Key_>(key));
+
+    auto& shard = shard_for(k);
+
+    std::scoped_lock guard{shard.lock};
+    shard.cache.insert(std::move(k), std::forward<Val_>(val));
+  }
+
+  /// Lookup a cache entry by key. Returns a copy of the value.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<std::string, float, 64, 8> c;
+  ///
+  /// assert(!c.find("hello").has_value());
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  [[nodiscard]] std::optional<Val> find(const Key& key) {
+    auto& shard = shard_for(key);
+
+    const auto guard = lock_for_lookup(shard);
+    if (const auto found = shard.cache.find(key); found) {
+      return found->get();
+    }
+
+    return std::nullopt;
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`.
+  /// Returns a copy of the found, or newly inserted value associated with the given key.
+  ///
+  /// The shard is not locked while computing the value. Concurrent misses on the same key do not compute the value again,
+  /// but wait for the first computation to finish instead (single-flight), and share its outcome: the value, or the
+  /// exception thrown by `f`.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<int, std::string, 64, 8> c;
+  ///
+  /// auto v = c.find_or_insert_with(42, [](int) { return "The Answer"; });
+  ///
+  /// assert(v == "The Answer");
+  /// assert(c.contains(42));
+  /// ```
+  template<typename F>
+  [[nodiscard]] Val find_or_insert_with(const Key& key, F f) {
+    if (auto found = find(key); found) {
+      return *std::move(found);
+    }
+
+    auto& shard = shard_for(key);
+
+    std::unique_lock guard{shard.lock};
+    if (const auto found = shard.cache.find(key); found) {
+      return found->get(); // Inserted meanwhile.
+    }
+
+    const auto release = [&shard](flight_t& flight) {
+      if (--flight.refs == 0) {
+        flight.key.reset();
+        flight.val.reset();
+        flight.error = nullptr;
+      }
+    };
+
+    // Follow a computation in flight.
+    if (const auto flight = std::ranges::find(shard.flights, key, [](const auto& fFlight) { return fFlight.key; }); flight != shard.flights.end()) {
+      ++flight->refs;
+      guard.unlock();
+
+      flight->done.wait(0, std::memory_order_acquire);
+
+      std::optional<Val> val;
+      std::exception_ptr error = flight->error;
+
+      if (!error) {
+        try {
+          val = *flight->val;
+        } catch (...) {
+          error = std::current_exception();
+        }
+      }
+
+      guard.lock();
+      release(*flight);
+      guard.unlock();
+
+      if (error) {
+        std::rethrow_exception(error);
+      }
+
+      return *std::move(val);
+    }
+
+    // Lead a new computation (if there is room to track it).
+    const auto flight = std::ranges::find_if(shard.flights, [](const auto& fFlight) { return !fFlight.key; });
+    if (flight != shard.flights.end()) {
+      flight->key  = key;
+      flight->refs = 1;
+      flight->done.store(0, std::memory_order_relaxed);
+    }
+
+    guard.unlock();
+
+    std::optional<Val> val;
+    std::exception_ptr error;
+
+    try {
+      val = f(key);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    guard.lock();
+
+    // NOTE: The outcome is published before the value is inserted, so that the waiters are woken even if the insert (or
+    //       an eviction hook) throws. If the value cannot be copied for them, they get that exception instead.
+    if (flight != shard.flights.end()) {
+      flight->error = error;
+
+      try {
+        flight->val = val;
+      } catch (...) {
+        flight->error = std::current_exception();
+      }
+
+      flight->done.store(1, std::memory_order_release);
+      flight->done.notify_all();
+
+      release(*flight);
+    }
+
+    if (val) {
+      shard.cache.insert(key, *val);
+    }
+
+    guard.unlock();
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    return *std::move(val);
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<int, std::string, 64, 8> c;
+  ///
+  /// assert(!c.contains(42));
+  ///
+  /// c.insert(42, "The Answer");
+  ///
+  /// assert(c.contains(42));
+  /// ```
+  [[nodiscard]] bool contains(const Key& key) const {
+    auto& shard = shard_for(key);
+
+    if constexpr (requires { shard.lock.lock_shared(); }) {
+      std::shared_lock guard{shard.lock};
+      return shard.cache.contains(key);
+    } else {
+      std::scoped_lock guard{shard.lock};
+      return shard.cache.contains(key);
+    }
+  }
+
+  /// Get the statistics counted so far, summed over all shards. Shards are read one by one (without locking), so the sum
+  /// is not a snapshot of the whole cache while it is in use.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<std::string, float, 64, 8, mc::stats::counters> c;
+  ///
+  /// assert(!c.contains("hello"));
+  /// assert(c.statistics().misses == 1);
+  /// ```
+  [[nodiscard]] cache_stats statistics() const noexcept requires COUNTS_STATS {
+    cache_stats result;
+    for (const auto& shard : shards) {
+      result += shard.cache.statistics();
+    }
+
+    return result;
+  }
+
+  /// Set a function to call with the key and value of every entry about to be evicted (replaced by an insert). The hook
+  /// is called with the shard locked, and possibly from multiple threads at once.
+  void set_eviction_hook(const std::function<void(const Key&, const Val&)>& hook) requires COUNTS_STATS {
+    for (auto& shard : shards) {
+      std::scoped_lock guard{shard.lock};
+      shard.cache.set_eviction_hook(hook);
+    }
+  }
+
+  /// Clear the cache.
+  ///
+  /// Shards are cleared one by one; concurrent insertions in shards that were already cleared are retained.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// concurrent_memo_cache<std::string, float, 64, 8> c;
+  ///
+  /// c.insert("hello", 42);
+  /// c.clear();
+  ///
+  /// assert(!c.contains("hello"));
+  /// ```
+  void clear() {
+    for (auto& shard : shards) {
+      std::scoped_lock guard{shard.lock};
+      shard.cache.clear();
+    }
+  }
+
+  /// Clear the cache, and destroy all values (see `memo_cache::purge`).
+  void purge() {
+    for (auto& shard : shards) {
+      std::scoped_lock guard{shard.lock};
+      shard.cache.purge();
+    }
+  }
+};
+
+namespace detail {
+
+/// Source of unique (never reused) cache identities, for caches with thread-local state.
+inline std::atomic<std::uint64_t> next_cache_id{1};
+
+} // namespace detail
+
+///
+/// A thread-safe, two-level key/value cache: a small `memo_cache` per thread (L1) in front of a shared
+/// `concurrent_memo_cache` (L2).
+///
+/// Lookups first scan the L1 of the calling thread, without any synchronization nor writes to shared memory (only the
+/// clear epoch of the cache is read). L1 misses fall through to the L2 (and then to `f`); the values found there are
+/// promoted into the L1. Values are returned by copy.
+///
+/// The L1s hold `LocalSize` slots each, with FIFO eviction. A thread has four L1s per cache type, assigned to the caches
+/// it uses by (unique) cache identity, so memory stays bounded: a cache taking over an L1 from another cache first clears
+/// it. All options (including the lock option) apply to the L2, which holds `Size` slots in `Shards` shards.
+///
+/// NOTE: Intended for memoizing pure functions, i.e. a key is only ever associated with a single value. Another thread's
+///       L1 may still return an older value after `insert` overwrites that of a key; `clear` applies to all threads.
+///
+template<std::regular Key, std::regular Val, std::size_t LocalSize, std::size_t Size, std::size_t Shards, typename... Options>
+class tiered_memo_cache {
+  static_assert(LocalSize > 0);
+
+  using local_cache_t = memo_cache<Key, Val, LocalSize>;
+
+  static constexpr std::size_t LOCAL_WAYS = 4;
+
+  struct local_t {
+    std::uint64_t owner{}; // The identity of the cache holding the L1, or zero.
+    std::uint64_t epoch{}; // The clear epoch of the owner when it was last cleared.
+    local_cache_t cache;
+  };
+
+  concurrent_memo_cache<Key, Val, Size, Shards, Options...> shared;
+
+  const std::uint64_t id = detail::next_cache_id.fetch_add(1, std::memory_order_relaxed);
+
+  alignas(detail::cache_line_size) std::atomic<std::uint64_t> epoch{}; // Bumped by `clear`.
+
+  /// The L1 of the calling thread, cleared if it held entries of another cache, or from before the last `clear`.
+  [[nodiscard]] local_cache_t& local() {
+    static thread_local std::array<local_t, LOCAL_WAYS> locals;
+
+    auto& l = locals[static_cast<std::size_t>(id % LOCAL_WAYS)];
+
+    if (const auto e = epoch.load(std::memory_order_acquire); l.owner != id || l.epoch != e) {
+      l.cache.clear();
+      l.owner = id;
+      l.epoch = e;
+    }
+
+    return l.cache;
+  }
+
+public:
+  tiered_memo_cache() = default;
+
+  // NOTE: Not copyable nor movable, as the L1s refer to the cache by identity.
+  tiered_memo_cache(const tiered_memo_cache&)            = delete;
+  tiered_memo_cache& operator=(const tiered_memo_cache&) = delete;
+
+  /// Get the (fixed) size of the shared cache.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// tiered_memo_cache<std::string, float, 8, 64, 8> c;
+  ///
+  /// assert(c.size() == 64);
+  /// ```
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return Size;
+  }
+
+  /// Get the (fixed) size of the cache of every thread.
+  [[nodiscard]] constexpr std::size_t local_size() const noexcept {
+    return LocalSize;
+  }
+
+  /// Insert a key/value pair, in both the shared cache and the cache of the calling thread.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// tiered_memo_cache<std::string, float, 8, 64, 8> c;
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  void insert(const Key& key, const Val& val) {
+    shared.insert(key, val);
+    local().insert(key, val);
+  }
+
+  /// Lookup a cache entry by key. Returns a copy of the value.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// tiered_memo_cache<std::string, float, 8, 64, 8> c;
+  ///
+  /// assert(!c.find("hello").has_value());
+  ///
+  /// c.insert("hello", 42);
+  ///
+  /// assert(c.find("hello").value() == 42);
+  /// ```
+  [[nodiscard]] std::optional<Val> find(const Key& key) {
+    auto& l1 = local();
+
+    if (const auto found = l1.find(key); found) {
+      return found->get();
+    }
+
+    auto found = shared.find(key);
+    if (found) {
+      l1.insert(key, *found);
+    }
+
+    return found;
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`. Returns a copy of the
+  /// found, or newly inserted value associated with the given key.
+  ///
+  /// Misses in the shared cache are single-flight, just like `concurrent_memo_cache::find_or_insert_with`.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// tiered_memo_cache<int, std::string, 8, 64, 8> c;
+  ///
+  /// auto v = c.find_or_insert_with(42, [](int) { return "The Answer"; });
+  ///
+  /// assert(v == "The Answer");
+  /// assert(c.contains(42));
+  /// ```
+  template<typename F>
+  [[nodiscard]] Val find_or_insert_with(const Key& key, F f) {
+    auto& l1 = local();
+
+    if (const auto found = l1.find(key); found) {
+      return found->get();
+    }
+
+    auto val = shared.find_or_insert_with(key, std::move(f));
+    l1.insert(key, val);
+
+    return val;
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// tiered_memo_cache<int, std::string, 8, 64, 8> c;
+  ///
+  /// assert(!c.contains(42));
+  ///
+  /// c.insert(42, "The Answer");
+  ///
+  /// assert(c.contains(42));
+  /// ```
+  [[nodiscard]] bool contains(const Key& key) {
+    return local().contains(key) || shared.contains(key);
+  }
+
+  /// Clear the cache, including the caches of all threads (lazily, on their next lookup).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// tiered_memo_cache<std::string, float, 8, 64, 8> c;
+  ///
+  /// c.insert("hello", 42);
+  /// c.clear();
+  ///
+  /// assert(!c.contains("hello"));
+  /// ```
+  void clear() {
+    // NOTE: The shared cache is cleared first, so that threads clearing their L1 cannot promote its old entries again.
+    shared.clear();
+    epoch.fetch_add(1, std::memory_order_release);
+  }
+};
+
+namespace detail {
+
+/// A coroutine that starts eagerly, runs detached, and frees itself on completion.
+struct detached_task {
+  struct promise_type {
+    detached_task get_return_object() noexcept {
+      return {};
+    }
+
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+
+    void return_void() noexcept {}
+
+    [[noreturn]] void unhandled_exception() noexcept {
+      std::terminate(); // NOTE: Detached tasks handle their exceptions themselves.
+    }
+  };
+};
+
+} // namespace detail
+
+///
+/// A fixed-size key/value cache with retention management (a `memo_cache`), that memoizes asynchronous computations
+/// with coroutines.
+///
+/// `co_await c.find_or_insert_async(key, f)` returns a cached value right away, or awaits the awaitable returned by
+/// `f(key)` (e.g. a coroutine task performing an RPC), inserts its result, and resumes. Concurrent awaiters of the same
+/// key share a single computation (and its outcome: the value, or the exception thrown), so thousands of lookups can be
+/// in flight without blocking a thread.
+///
+/// All `memo_cache` options apply.
+///
+/// NOTE: Not thread-safe, just like `memo_cache`: the computations must complete on the thread using the cache (e.g. an
+///       I/O event loop), and the cache must outlive them. Waiters are resumed on completion, in the order they arrived.
+///
+template<std::regular Key, std::regular Val, std::size_t Size, typename... Options>
+class async_memo_cache {
+  /// A computation in flight, and the coroutines awaiting it.
+  struct flight_t {
+    Key                                  key;
+    std::vector<std::coroutine_handle<>> waiters{};
+    bool                                 done{};
+    std::optional<Val>                   val{};
+    std::exception_ptr                   error{};
+  };
+
+  memo_cache<Key, Val, Size, Options...> cache;
+  std::vector<std::shared_ptr<flight_t>> flights; // NOTE: Searched linearly, just like the cache itself.
+
+  template<typename F>
+  static detail::detached_task compute(async_memo_cache& self, std::shared_ptr<flight_t> flight, F f) {
+    try {
+      Val val = co_await std::invoke(f, std::as_const(flight->key));
+      self.cache.insert(flight->key, val);
+      flight->val = std::move(val);
+    } catch (...) {
+      flight->error = std::current_exception();
+    }
+
+    std::erase(self.flights, flight);
+
+    flight->done = true;
+    for (const auto waiter : std::exchange(flight->waiters, {})) {
+      waiter.resume();
+    }
+  }
+
+  template<typename F>
+  class awaitable {
+    friend class async_memo_cache;
+
+    async_memo_cache&         self;
+    const Key&                key;
+    F                         f;
+    std::optional<Val>        found;
+    std::shared_ptr<flight_t> flight;
+
+    awaitable(async_memo_cache& self_, const Key& key_, F f_) : self{self_}, key{key_}, f{std::move(f_)} {}
+
+  public:
+    [[nodiscard]] bool await_ready() {
+      if (const auto v = self.cache.find(key)) {
+        found = v->get();
+        return true;
+      }
+
+      return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiter) {
+      const auto same_key = [this](const auto& fl) { return fl->key == key; };
+
+      if (const auto it = std::ranges::find_if(self.flights, same_key); it != self.flights.end()) {
+        flight = *it;
+      } else {
+        flight = std::make_shared<flight_t>(flight_t{.key = key});
+        self.flights.push_back(flight);
+        compute(self, flight, std::move(f));
+
+        // The computation may have completed synchronously.
+        if (flight->done) {
+          return false;
+        }
+      }
+
+      flight->waiters.push_back(awaiter);
+      return true;
+    }
+
+    [[nodiscard]] Val await_resume() {
+      if (found) {
+        return *std::move(found);
+      }
+
+      if (flight->error) {
+        std::rethrow_exception(flight->error);
+      }
+
+      return *flight->val;
+    }
+  };
+
+public:
+  async_memo_cache() = default;
+
+  // NOTE: Not copyable nor movable, as computations in flight refer to the cache.
+  async_memo_cache(const async_memo_cache&)            = delete;
+  async_memo_cache& operator=(const async_memo_cache&) = delete;
+
+  /// Get the (fixed) size of the cache.
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return Size;
+  }
+
+  /// Get the number of computations in flight.
+  [[nodiscard]] std::size_t pending() const noexcept {
+    return flights.size();
+  }
+
+  /// Insert a key/value pair.
+  void insert(const Key& key, const Val& val) {
+    cache.insert(key, val);
+  }
+
+  /// Lookup a cache entry by key. Does not wait for computations in flight. Returns a copy of the value.
+  [[nodiscard]] std::optional<Val> find(const Key& key) {
+    if (const auto found = cache.find(key)) {
+      return found->get();
+    }
+
+    return std::nullopt;
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed asynchronously by `f`: an
+  /// awaitable (e.g. coroutine task) returned by `f(key)`. Returns an awaitable for (a copy of) the found, or newly
+  /// inserted value associated with the given key.
+  ///
+  /// `key` must stay valid until the returned awaitable is resumed; `f` is only called if no computation for the key is
+  /// in flight yet.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <memo_cache.hpp>
+  ///
+  /// async_memo_cache<int, std::string, 64> c;
+  ///
+  /// task<std::string> fetch(int key); // E.g. performing an RPC.
+  ///
+  /// task<void> handle(int key) {
+  ///   auto value = co_await c.find_or_insert_async(key, [](int k) { return fetch(k); });
+  ///   // ..
+  /// }
+  /// ```
+  template<typename F>
+    requires std::invocable<F&, const Key&>
+  [[nodiscard]] awaitable<F> find_or_insert_async(const Key& key, F f) {
+    return {*this, key, std::move(f)};
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  [[nodiscard]] bool contains(const Key& key) const {
+    return cache.contains(key);
+  }
+
+  /// Clear the cache. Computations in flight still insert their values on completion.
+  void clear() {
+    cache.clear();
+  }
+};
+
+namespace detail {
+
+class robust_mutex;
+
+#if defined(MC_SHARED_MEMORY)
+
+/// A mutex in memory shared between processes, that is handed to the next process to lock it if its owner dies while
+/// holding it. Ownership is tracked by the kernel (per thread), so this holds across PID namespaces and pid reuse.
+///
+/// NOTE: Constructed in place in the (shared) memory, and never destroyed: it outlives the processes using it.
+class robust_mutex {
+  ::pthread_mutex_t mutex;
+
+public:
+  /// The outcome of a (try) lock: `recovered` if the previous owner died while holding the mutex. The caller then owns it,
+  /// and has to repair whatever the mutex protects.
+  enum class status { locked, busy, recovered };
+
+  robust_mutex() noexcept {
+    ::pthread_mutexattr_t attr;
+    ::pthread_mutexattr_init(&attr);
+    ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    ::pthread_mutex_init(&mutex, &attr);
+    ::pthread_mutexattr_destroy(&attr);
+  }
+
+  robust_mutex(const robust_mutex&)            = delete;
+  robust_mutex& operator=(const robust_mutex&) = delete;
+
+  [[nodiscard]] status lock() noexcept {
+    return recover(::pthread_mutex_lock(&mutex));
+  }
+
+  [[nodiscard]] status try_lock() noexcept {
+    return recover(::pthread_mutex_trylock(&mutex));
+  }
+
+  void unlock() noexcept {
+    ::pthread_mutex_unlock(&mutex);
+  }
+
+private:
+  [[nodiscard]] status recover(int result) noexcept {
+    if (result == EOWNERDEAD) {
+      ::pthread_mutex_consistent(&mutex);
+      return status::recovered;
+    }
+
+    return (result == 0) ? status::locked : status::busy;
+  }
+};
+
+#endif
+
+/// Types that can be copied word by word through a seqlock.
+template<typename T>
+concept seqlock_storable = std::is_trivially_copyable_v<T> && std::default_initializable<T>;
+
+/// A key/value slot protected by a sequence lock (for a single writer, and any number of readers).
+///
+/// Readers copy the slot contents optimistically, and retry if the sequence number changed (or was odd, i.e. a write was
+/// in progress) meanwhile. The contents are stored as relaxed atomic words, so that racing copies are well-defined.
+///
+/// If `Shared`, the slot lives in memory shared between processes: writers then take a (robust) mutex around the sequence
+/// lock, so there may be any number of them. A slot left locked by a writer that died mid-write is recovered (emptied) by
+/// the next reader or writer to reach it.
+template<seqlock_storable Key, seqlock_storable Val, bool Shared = false>
+class seqlock_slot {
+  struct payload_t {
+    Key key;
+    Val val;
+  };
+
+  static constexpr std::size_t WORDS     = (sizeof(payload_t) + 7) / 8;
+  static constexpr std::size_t KEY_WORDS = (offsetof(payload_t, key) + sizeof(Key) + 7) / 8;
+
+  // NOTE: A write only takes a few stores; a reader gives up on a slot that stays locked by a live writer (e.g. one that
+  //       was preempted mid-write) after this many retries, checking whether the writer died every `RECOVER_INTERVAL`.
+  static constexpr std::size_t MAX_RETRIES      = Shared ? 4096 : std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t RECOVER_INTERVAL = 64;
+
+  static_assert(!Shared || (std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free),
+                "Atomics shared between processes must be lock free.");
+
+  // NOTE: Mutable, as readers recover slots abandoned by a writer (in a `Shared` slot).
+  [[no_unique_address]] mutable std::conditional_t<Shared, robust_mutex, std::tuple<>> writer;
+  mutable std::atomic<std::uint32_t> sequence{};
+  mutable std::atomic<bool>          occupied{};
+  std::array<std::atomic<std::uint64_t>, WORDS> words{};
+
+  /// Empty the slot if its writer died mid-write (the contents may be torn). Returns `false` if a (live) writer holds it.
+  [[nodiscard]] bool recover() const noexcept requires Shared {
+    const auto status = writer.try_lock();
+    if (status == robust_mutex::status::busy) {
+      return false;
+    }
+
+    if (status == robust_mutex::status::recovered) {
+      occupied.store(false, std::memory_order_relaxed);
+      sequence.store((sequence.load(std::memory_order_relaxed) | 1) + 1, std::memory_order_release);
+    }
+
+    writer.unlock();
+
+    return true;
+  }
+
+  /// Take a consistent snapshot of the first `N` payload words. Returns `false` if the slot is unoccupied (or, if
+  /// `Shared`, stays locked).
+  template<std::size_t N>
+  [[nodiscard]] bool snapshot(std::array<std::uint64_t, WORDS>& raw) const noexcept {
+    for (std::size_t retries = 0; retries < MAX_RETRIES; ++retries) {
+      const auto before = sequence.load(std::memory_order_acquire);
+      if ((before & 1) != 0) {
+        // A write is in progress, unless the writer died.
+        if constexpr (Shared) {
+          if (retries % RECOVER_INTERVAL == 0 && recover()) {
+            continue;
+          }
+        }
+
+        cpu_relax();
+        continue;
+      }
+
+      const auto is_occupied = occupied.load(std::memory_order_relaxed);
+      for (std::size_t i = 0; i < N; ++i) {
+        raw[i] = words[i].load(std::memory_order_relaxed);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == before) {
+        return is_occupied;
+      }
+    }
+
+    return false;
+  }
+
+  template<typename F>
+  void write(F&& f) noexcept requires (!Shared) {
+    const auto before = sequence.load(std::memory_order_relaxed);
+
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::forward<F>(f)();
+
+    sequence.store(before + 2, std::memory_order_release);
+  }
+
+  /// Like `write`, for any number of writers. Returns `false` if another writer holds the slot.
+  template<typename F>
+  [[nodiscard]] bool try_write(F&& f) noexcept requires Shared {
+    if (writer.try_lock() == robust_mutex::status::busy) {
+      return false;
+    }
+
+    // NOTE: The sequence is still odd if the previous writer died mid-write; this write then completes it.
+    const auto locked = sequence.load(std::memory_order_relaxed) | 1;
+
+    sequence.store(locked, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::forward<F>(f)();
+
+    sequence.store(locked + 1, std::memory_order_release);
+    writer.unlock();
+
+    return true;
+  }
+
+  [[nodiscard]] static std::array<std::uint64_t, WORDS> pack(const Key& key, const Val& val) noexcept {
+    std::array<std::uint64_t, WORDS> raw{};
+
+    const payload_t payload{key, val};
+    std::memcpy(raw.data(), &payload, sizeof(payload_t));
+
+    return raw;
+  }
+
+public:
+  /// Returns a snapshot of the key, if the slot is occupied.
+  [[nodiscard]] std::optional<Key> load_key() const noexcept {
+    std::array<std::uint64_t, WORDS> raw{};
+    if (!snapshot<KEY_WORDS>(raw)) {
+      return std::nullopt;
+    }
+
+    payload_t payload;
+    std::memcpy(&payload, raw.data(), sizeof(payload_t));
+    return payload.key;
+  }
+
+  /// Returns a snapshot of the value, if the slot is occupied and holds `key`.
+  [[nodiscard]] std::optional<Val> load_value(const Key& key) const noexcept {
+    std::array<std::uint64_t, WORDS> raw{};
+    if (!snapshot<WORDS>(raw)) {
+      return std::nullopt;
+    }
+
+    payload_t payload;
+    std::memcpy(&payload, raw.data(), sizeof(payload_t));
+    if (!(payload.key == key)) {
+      return std::nullopt; // Replaced meanwhile.
+    }
+
+    return payload.val;
+  }
+
+  /// Store a key/value pair. Must only be called by the (single) writer.
+  void store(const Key& key, const Val& val) noexcept requires (!Shared) {
+    const auto raw = pack(key, val);
+
+    write([&] {
+      occupied.store(true, std::memory_order_relaxed);
+      for (std::size_t i = 0; i < WORDS; ++i) {
+        words[i].store(raw[i], std::memory_order_relaxed);
+      }
+    });
+  }
+
+  /// Mark the slot unoccupied. Must only be called by the (single) writer.
+  void reset() noexcept requires (!Shared) {
+    write([&] { occupied.store(false, std::memory_order_relaxed); });
+  }
+
+  /// Store a key/value pair. Returns `false` (storing nothing) if another writer holds the slot.
+  [[nodiscard]] bool try_store(const Key& key, const Val& val) noexcept requires Shared {
+    const auto raw = pack(key, val);
+
+    return try_write([&] {
+      occupied.store(true, std::memory_order_relaxed);
+      for (std::size_t i = 0; i < WORDS; ++i) {
+        words[i].store(raw[i], std::memory_order_relaxed);
+      }
+    });
+  }
+
+  /// Mark the slot unoccupied. Returns `false` if another writer holds the slot.
+  [[nodiscard]] bool try_reset() noexcept requires Shared {
+    return try_write([&] { occupied.store(false, std::memory_order_relaxed); });
+  }
+};
+
+} // namespace detail
+
+///
+/// A fixed-size key/value cache with FIFO retention management for a single writer thread and any number of reader threads,
+/// for use with trivially copyable types.
+///
+/// Every slot is protected by a sequence lock: lookups copy the slot contents and retry if a write interfered. Lookups
+/// never take a lock nor write to shared memory, so readers do not contend with each other at all.
+///
+/// NOTE: Only `find` and `contains` may be called concurrently; all other member functions must be called from one
+///       (writer) thread at a time.
+///
+template<detail::seqlock_storable Key, detail::seqlock_storable Val, std::size_t Size>
+  requires std::equality_comparable<Key>
+class seqlock_memo_cache {
+  static_assert(Size > 0);
+  static_assert(Size <= detail::max_size<Key>, "Semantic constraint: use this cache for small sizes only (see performance notes).");
+
+  std::array<detail::seqlock_slot<Key, Val>, Size> slots;
+  std::size_t cursor{}; // Only accessed by the writer.
+
+  [[nodiscard]] std::size_t find_slot(const Key& key) const noexcept {
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (const auto k = slots[i].load_key(); k && (*k == key)) {
+        return i;
+      }
+    }
+
+    return Size;
+  }
+
+  /// Replace slot under cursor and shift cursor position.
+  void replace_and_shift(const Key& key, const Val& val) noexcept {
+    slots[cursor].store(key, val);
+
+    // Move the cursor over the slots sequentially, creating FIFO behavior.
+    cursor = (cursor + 1) % Size;
   }
 
 public:
@@ -54,7 +5036,7 @@ public:
   /// #include <cassert>
   /// #include <memo_cache.hpp>
   ///
-  /// memo_cache<std::string, float, 4> c;
+  /// seqlock_memo_cache<int, float, 4> c;
   ///
   /// assert(c.size() == 4);
   /// ```
@@ -62,7 +5044,7 @@ public:
     return Size;
   }
 
-  /// Insert a key/value pair.
+  /// Insert a key/value pair. Must only be called by the writer.
   ///
   /// # Examples
   ///
@@ -70,28 +5052,22 @@ public:
   /// #include <cassert>
   /// #include <memo_cache.hpp>
   ///
-  /// memo_cache<std::string, float, 4> c;
-  ///
-  /// assert(!c.find("hello").has_value());
+  /// seqlock_memo_cache<int, float, 4> c;
   ///
-  /// c.insert("hello", 42);
+  /// c.insert(17, 42);
   ///
-  /// assert(c.find("hello").has_value());
-  /// assert(c.find("hello").value() == 42);
+  /// assert(c.find(17).value() == 42);
   /// ```
-  template<typename Key_, typename Val_>
-  void insert(Key_&& key, Val_&& val) requires (std::assignable_from<Key, Key_> || std::convertible_to<Key_, Key>)
-                                            && (std::assignable_from<Val, Val_> || std::convertible_to<Val_, Val>)
-  {
+  void insert(const Key& key, const Val& val) noexcept {
     // Overwrite values for identical keys.
-    if (auto found = find(key); found) {
-      found.value().get() = std::forward<Val_>(val);
+    if (const auto i = find_slot(key); i != Size) {
+      slots[i].store(key, val);
     } else {
-      replace_and_shift(std::forward<Key_>(key), std::forward<Val_>(val));
+      replace_and_shift(key, val);
     }
   }
 
-  /// Lookup a cache entry by key.
+  /// Lookup a cache entry by key. Returns a copy of the value. May be called concurrently with any other member function.
   ///
   /// # Examples
   ///
@@ -99,27 +5075,28 @@ public:
   /// #include <cassert>
   /// #include <memo_cache.hpp>
   ///
-  /// memo_cache<std::string, float, 4> c;
+  /// seqlock_memo_cache<int, float, 4> c;
   ///
-  /// assert(!c.find("hello").has_value());
+  /// assert(!c.find(17).has_value());
   ///
-  /// c.insert("hello", 42);
+  /// c.insert(17, 42);
   ///
-  /// assert(c.find("hello").has_value());
-  /// assert(c.find("hello").value() == 42);
+  /// assert(c.find(17).value() == 42);
   /// ```
-  [[nodiscard]] std::optional<std::reference_wrapper<Val>> find(const Key& key) {
-    const auto slot = std::ranges::find_if(buffer, [&key](const auto& fSlot) { return fSlot.val && (fSlot.key == key); });
-    if (slot != buffer.cend()) {
-      // SAFETY: The slot value was found by definition.
-      return std::ref(*slot->val);
+  [[nodiscard]] std::optional<Val> find(const Key& key) const noexcept {
+    for (const auto& slot : slots) {
+      if (const auto k = slot.load_key(); k && (*k == key)) {
+        if (auto val = slot.load_value(key); val) {
+          return val;
+        }
+      }
     }
 
     return std::nullopt;
   }
 
   /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`.
-  /// Returns a reference to the found, or newly inserted value associated with the given key.
+  /// Returns a copy of the found, or newly inserted value. Must only be called by the writer.
   ///
   /// # Examples
   ///
@@ -127,26 +5104,27 @@ public:
   /// #include <cassert>
   /// #include <memo_cache.hpp>
   ///
-  /// memo_cache<int, std::string, 4> c;
-  ///
-  /// assert(!c.contains(42));
+  /// seqlock_memo_cache<int, float, 4> c;
   ///
-  /// auto v = c.find_or_insert_with(42, [] { return "The Answer"; });
+  /// auto v = c.find_or_insert_with(17, [](int) { return 42.0f; });
   ///
-  /// assert(v == "The Answer");
-  /// assert(c.find(42).has_value());
-  /// assert(c.find(42).value() == "The Answer");
+  /// assert(v == 42);
+  /// assert(c.contains(17));
   /// ```
   template<typename F>
-  [[nodiscard]] std::reference_wrapper<Val> find_or_insert_with(const Key& key, F f) {
-    if (auto slot = find(key); slot) {
-      return *slot;
+  [[nodiscard]] Val find_or_insert_with(const Key& key, F f) {
+    if (auto found = find(key); found) {
+      return *found;
     }
 
-    return replace_and_shift(key, f(key));
+    const Val val = f(key);
+    replace_and_shift(key, val);
+
+    return val;
   }
 
-  /// Returns `true` if the cache contains a value for the specified key.
+  /// Returns `true` if the cache contains a value for the specified key. May be called concurrently with any other member
+  /// function.
   ///
   /// # Examples
   ///
@@ -154,19 +5132,19 @@ public:
   /// #include <cassert>
   /// #include <memo_cache.hpp>
   ///
-  /// memo_cache<int, std::string, 4> c;
+  /// seqlock_memo_cache<int, float, 4> c;
   ///
-  /// assert(!c.contains(42));
+  /// assert(!c.contains(17));
   ///
-  /// c.insert(42, "The Answer");
+  /// c.insert(17, 42);
   ///
-  /// assert(c.contains(42));
+  /// assert(c.contains(17));
   /// ```
-  [[nodiscard]] bool contains(const Key& key) const {
-    return std::ranges::any_of(buffer, [&key](const auto& fSlot) { return fSlot.val && (fSlot.key == key); });
+  [[nodiscard]] bool contains(const Key& key) const noexcept {
+    return find_slot(key) != Size;
   }
 
-  /// Clear the cache.
+  /// Clear the cache. Must only be called by the writer.
   ///
   /// # Examples
   ///
@@ -174,22 +5152,522 @@ public:
   /// #include <cassert>
   /// #include <memo_cache.hpp>
   ///
-  /// memo_cache<std::string, float, 4> c;
+  /// seqlock_memo_cache<int, float, 4> c;
   ///
-  /// c.insert("hello", 42);
+  /// c.insert(17, 42);
+  /// c.clear();
   ///
-  /// assert(c.find("hello").has_value());
-  /// assert(c.find("hello").value() == 42);
+  /// assert(!c.contains(17));
+  /// ```
+  void clear() noexcept {
+    for (auto& slot : slots) {
+      slot.reset();
+    }
+
+    cursor = 0;
+  }
+};
+
+#if defined(MC_SHARED_MEMORY)
+
+namespace detail {
+
+/// Layout of the shared memory segment of a `shared_memory_memo_cache`.
+template<typename Key, typename Val, std::size_t Size>
+struct shared_segment {
+  // NOTE: The initialization word is the first word of the (zero-filled) segment, followed by the initialization lock,
+  //       which is constructed (by the first process to open the segment) before anything else.
+  static constexpr std::uint64_t UNINITIALIZED = 0;
+  static constexpr std::uint64_t LOCKING       = 1; // The initialization lock is being constructed.
+  static constexpr std::uint64_t LOCKABLE      = 2;
+  static constexpr std::uint64_t READY         = 3;
+
+  std::atomic<std::uint64_t> init;
+  robust_mutex               init_lock;
+  snapshot_header            layout;
+  std::atomic<std::uint64_t> cursor;
+
+  std::array<seqlock_slot<Key, Val, true>, Size> slots;
+};
+
+} // namespace detail
+
+///
+/// A fixed-size key/value cache with FIFO retention management in a POSIX shared memory segment, for use with trivially
+/// copyable types, so that all processes on a host (e.g. workers computing the same results) share a single cache.
+///
+/// Like `seqlock_memo_cache`, every slot is protected by a sequence lock, but writers take it by compare-and-swap, so any
+/// number of threads and processes may insert concurrently. A store to a slot held by another writer is dropped (it is
+/// only a cache), as is one of two racing inserts of the same key, or a duplicate slot is used.
+///
+/// The first process to open the segment initializes it; if it dies meanwhile, the next process to open the segment takes
+/// over. The segment persists until it is removed (e.g. when the workers are redeployed). Processes may be in different
+/// PID namespaces (e.g. containers sharing `/dev/shm`), as writers are tracked by robust mutexes rather than by pid.
+///
+/// NOTE: All processes must be built with the same (layout of the) key and value types, which must not hold pointers or
+///       anything else only meaningful within one process. The segment sizes and layout are checked when opening it.
+///
+/// NOTE: A slot locked by a writer that died mid-write is emptied by the next lookup or insert to reach it. A process that
+///       dies within the few instructions constructing the initialization lock leaves the segment unusable (`open` gives
+///       up after a second) until it is removed.
+///
+template<detail::seqlock_storable Key, detail::seqlock_storable Val, std::size_t Size>
+  requires std::equality_comparable<Key>
+class shared_memory_memo_cache {
+  static_assert(Size > 0);
+  static_assert(Size <= detail::max_size<Key>, "Semantic constraint: use this cache for small sizes only (see performance notes).");
+
+  using segment_t = detail::shared_segment<Key, Val, Size>;
+
+  segment_t* segment{};
+
+  explicit shared_memory_memo_cache(segment_t* s) noexcept : segment(s) {}
+
+  static constexpr detail::snapshot_header expected_header() noexcept {
+    return {.key_size = sizeof(Key), .val_size = sizeof(Val), .size = Size, .buffer_size = sizeof(segment_t), .eviction_size = 0};
+  }
+
+  /// Initialize the segment, unless another process did (or does). Returns `false` if it holds another cache type, or its
+  /// initialization lock was never constructed.
+  [[nodiscard]] bool initialize() noexcept {
+    auto word = segment->init.load(std::memory_order_acquire);
+
+    if (word == segment_t::UNINITIALIZED
+        && segment->init.compare_exchange_strong(word, segment_t::LOCKING, std::memory_order_acquire, std::memory_order_acquire)) {
+      std::construct_at(&segment->init_lock);
+      segment->init.store(word = segment_t::LOCKABLE, std::memory_order_release);
+    }
+
+    for (const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1}; word == segment_t::LOCKING;
+         word = segment->init.load(std::memory_order_acquire)) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    // NOTE: An initializer that died (e.g. was killed) before it finished leaves the lock to the next process, which starts
+    //       over, as the segment is not marked ready yet.
+    if (word != segment_t::READY) {
+      static_cast<void>(segment->init_lock.lock());
+
+      if (segment->init.load(std::memory_order_acquire) != segment_t::READY) {
+        segment->layout = expected_header();
+        segment->cursor.store(0, std::memory_order_relaxed);
+        std::construct_at(&segment->slots);
+
+        segment->init.store(segment_t::READY, std::memory_order_release);
+      }
+
+      segment->init_lock.unlock();
+    }
+
+    return segment->layout == expected_header();
+  }
+
+  [[nodiscard]] std::size_t find_slot(const Key& key) const noexcept {
+    for (std::size_t i = 0; i < Size; ++i) {
+      if (const auto k = segment->slots[i].load_key(); k && (*k == key)) {
+        return i;
+      }
+    }
+
+    return Size;
+  }
+
+  /// Replace slot under the (shared) cursor and shift cursor position.
+  void replace_and_shift(const Key& key, const Val& val) noexcept {
+    // Move the cursor over the slots sequentially, creating FIFO behavior (across all processes).
+    const auto i = segment->cursor.fetch_add(1, std::memory_order_relaxed) % Size;
+
+    static_cast<void>(segment->slots[i].try_store(key, val));
+  }
+
+public:
+  /// Open the cache in the POSIX shared memory object `name` (e.g. `"/my-cache"`), creating it if it does not exist.
+  /// Returns `std::nullopt` if the object could not be opened or mapped, or holds another cache type.
   ///
-  /// c.clear();
+  /// # Examples
   ///
-  /// assert(!c.find("hello").has_value());
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// auto a = shared_memory_memo_cache<int, float, 4>::open("/example");
+  /// auto b = shared_memory_memo_cache<int, float, 4>::open("/example"); // E.g. in another process.
+  ///
+  /// a->insert(17, 42);
+  ///
+  /// assert(b->find(17).value() == 42);
+  ///
+  /// shared_memory_memo_cache<int, float, 4>::remove("/example");
+  /// ```
+  [[nodiscard]] static std::optional<shared_memory_memo_cache> open(const std::string& name) noexcept {
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+      return std::nullopt;
+    }
+
+    // NOTE: Every process sizes the (zero-filled) object, as its creator may not have yet; another size is another type.
+    struct ::stat st{};
+    const bool sized = (::fstat(fd, &st) == 0)
+                    && (std::cmp_equal(st.st_size, sizeof(segment_t))
+                        || (st.st_size == 0 && ::ftruncate(fd, static_cast<::off_t>(sizeof(segment_t))) == 0));
+
+    void* mapping = sized ? ::mmap(nullptr, sizeof(segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+      return std::nullopt;
+    }
+
+    // SAFETY: The segment is zero-filled (the initial state of its atomics) until initialized, which happens only once.
+    shared_memory_memo_cache cache{static_cast<segment_t*>(mapping)};
+    if (!cache.initialize()) {
+      return std::nullopt;
+    }
+
+    return cache;
+  }
+
+  /// Remove the shared memory object `name`. Processes that opened it keep using it; later calls to `open` create a new
+  /// one. Returns `false` if it did not exist (or could not be removed).
+  static bool remove(const std::string& name) noexcept {
+    return ::shm_unlink(name.c_str()) == 0;
+  }
+
+  shared_memory_memo_cache(const shared_memory_memo_cache&)            = delete;
+  shared_memory_memo_cache& operator=(const shared_memory_memo_cache&) = delete;
+
+  shared_memory_memo_cache(shared_memory_memo_cache&& other) noexcept : segment(std::exchange(other.segment, nullptr)) {}
+
+  shared_memory_memo_cache& operator=(shared_memory_memo_cache&& other) noexcept {
+    std::swap(segment, other.segment);
+    return *this;
+  }
+
+  ~shared_memory_memo_cache() {
+    if (segment) {
+      ::munmap(segment, sizeof(segment_t));
+    }
+  }
+
+  /// Get the (fixed) size of the cache.
+  [[nodiscard]] constexpr std::size_t size() const noexcept {
+    return Size;
+  }
+
+  /// Insert a key/value pair. May be called concurrently with any other member function, from any process.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// auto c = shared_memory_memo_cache<int, float, 4>::open("/example");
+  ///
+  /// c->insert(17, 42);
+  ///
+  /// assert(c->find(17).value() == 42);
+  /// ```
+  void insert(const Key& key, const Val& val) noexcept {
+    // Overwrite values for identical keys.
+    if (const auto i = find_slot(key); i != Size) {
+      static_cast<void>(segment->slots[i].try_store(key, val));
+    } else {
+      replace_and_shift(key, val);
+    }
+  }
+
+  /// Lookup a cache entry by key. Returns a copy of the value. May be called concurrently with any other member function,
+  /// from any process.
+  [[nodiscard]] std::optional<Val> find(const Key& key) const noexcept {
+    for (const auto& slot : segment->slots) {
+      if (const auto k = slot.load_key(); k && (*k == key)) {
+        if (auto val = slot.load_value(key); val) {
+          return val;
+        }
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  /// Get a value, or, if it does not exist in the cache, insert it using the value computed by `f`. Returns a copy of the
+  /// found, or newly inserted value. Processes missing the same key concurrently each compute (and insert) its value.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// auto c = shared_memory_memo_cache<int, float, 4>::open("/example");
+  ///
+  /// auto v = c->find_or_insert_with(17, [](int) { return 42.0f; });
+  ///
+  /// assert(v == 42);
+  /// assert(c->contains(17));
+  /// ```
+  template<typename F>
+  [[nodiscard]] Val find_or_insert_with(const Key& key, F f) {
+    if (auto found = find(key); found) {
+      return *found;
+    }
+
+    const Val val = f(key);
+    replace_and_shift(key, val);
+
+    return val;
+  }
+
+  /// Returns `true` if the cache contains a value for the specified key.
+  [[nodiscard]] bool contains(const Key& key) const noexcept {
+    return find_slot(key) != Size;
+  }
+
+  /// Clear the cache, for all processes. Slots written concurrently may keep (or get) their entries.
+  void clear() noexcept {
+    for (auto& slot : segment->slots) {
+      static_cast<void>(slot.try_reset());
+    }
+  }
+};
+
+#endif
+
+namespace detail {
+
+/// The (decayed) arguments of a memoized function with more than one parameter, as cache key.
+template<typename... Ts>
+struct args_key {
+  std::tuple<Ts...> values;
+
+  args_key() = default;
+  explicit args_key(const std::tuple<const Ts&...>& args) : values{args} {}
+
+  bool operator==(const args_key&) const = default;
+
+  /// Compare with the arguments of a call, without copying them.
+  bool operator==(const std::tuple<const Ts&...>& args) const {
+    return values == args;
+  }
+};
+
+/// The cache key type for the arguments of a memoized function: the argument itself for unary functions.
+template<typename... Args>
+struct args_key_for {
+  using type = args_key<std::decay_t<Args>...>;
+};
+
+template<typename Arg>
+struct args_key_for<Arg> {
+  using type = std::decay_t<Arg>;
+};
+
+template<typename... Args>
+using args_key_t = typename args_key_for<Args...>::type;
+
+/// The signature `R(Args...)` of a function (pointer), or of a class type with a single, non-template call operator.
+template<typename F>
+struct signature_of : signature_of<decltype(&F::operator())> {};
+
+template<typename R, typename... Args> struct signature_of<R(Args...)> { using type = R(Args...); };
+template<typename R, typename... Args> struct signature_of<R(Args...) noexcept> { using type = R(Args...); };
+template<typename R, typename... Args> struct signature_of<R (*)(Args...)> { using type = R(Args...); };
+template<typename R, typename... Args> struct signature_of<R (*)(Args...) noexcept> { using type = R(Args...); };
+template<typename C, typename R, typename... Args> struct signature_of<R (C::*)(Args...)> { using type = R(Args...); };
+template<typename C, typename R, typename... Args> struct signature_of<R (C::*)(Args...) noexcept> { using type = R(Args...); };
+template<typename C, typename R, typename... Args> struct signature_of<R (C::*)(Args...) const> { using type = R(Args...); };
+template<typename C, typename R, typename... Args> struct signature_of<R (C::*)(Args...) const noexcept> { using type = R(Args...); };
+
+template<typename F>
+using signature_of_t = typename signature_of<F>::type;
+
+/// The cache type of the given storage option, with the options in the given `std::tuple`.
+template<typename Storage, typename Key, typename Val, std::size_t Size, typename OptionTuple>
+struct storage_cache;
+
+template<typename Storage, typename Key, typename Val, std::size_t Size, typename... Options>
+struct storage_cache<Storage, Key, Val, Size, std::tuple<Options...>> {
+  using type = typename Storage::template cache<Key, Val, Size, Options...>;
+};
+
+} // namespace detail
+
+/// Cache storage of memoized functions, to be passed as option (e.g. `memoize<64, mc::storage::shared<8>>(f)`).
+namespace storage {
+
+/// A `memo_cache` owned by the memoized function (and copied along with it). Not thread-safe; declare the memoized
+/// function `thread_local` for a cache per thread. This is the default.
+struct local : detail::storage_option {
+  template<typename Key, typename Val, std::size_t Size, typename... Options>
+  using cache = memo_cache<Key, Val, Size, Options...>;
+};
+
+/// A `concurrent_memo_cache` with `Shards` shards, allocated once and shared by all copies of the memoized function.
+/// Requires `std::hash` for all argument types.
+template<std::size_t Shards = 8>
+struct shared : detail::storage_option {
+  template<typename Key, typename Val, std::size_t Size, typename... Options>
+  using cache = concurrent_memo_cache<Key, Val, Size, Shards, Options...>;
+};
+
+/// A `tiered_memo_cache` with a cache of `LocalSize` entries per thread, in front of a shared cache with `Shards` shards,
+/// allocated once and shared by all copies of the memoized function. Requires `std::hash` for all argument types.
+template<std::size_t LocalSize = 16, std::size_t Shards = 8>
+struct tiered : detail::storage_option {
+  template<typename Key, typename Val, std::size_t Size, typename... Options>
+  using cache = tiered_memo_cache<Key, Val, LocalSize, Size, Shards, Options...>;
+};
+
+} // namespace storage
+
+template<typename F, typename Signature, std::size_t Size, typename... Options>
+class memoized;
+
+///
+/// A pure function `f`, memoized using a cache of `Size` entries. Callable with the same arguments as `f`, and returns
+/// (a copy of) the cached result.
+///
+/// The cache key is the (decayed) argument for unary functions, or a tuple of the (decayed) arguments otherwise. With
+/// local storage, the arguments are compared in place, and only copied into the cache on a miss. Shared storage always
+/// constructs a key. Pointer arguments (incl. C strings) are compared by address.
+///
+/// All cache options apply, with the addition of the storage option:
+///
+///   - `mc::storage::local` (default), `mc::storage::shared<Shards>` or `mc::storage::tiered<LocalSize, Shards>`: the
+///     cache storage.
+///
+/// Usually constructed using `memoize`, but the signature can be specified explicitly for overloaded or generic callables
+/// (e.g. `memoized<decltype(f), float(int, int), 64>{f}`).
+///
+template<typename F, typename R, typename... Args, std::size_t Size, typename... Options>
+class memoized<F, R(Args...), Size, Options...> {
+  static_assert(detail::valid_options<Options...>, "Options must be cache options, each kind specified at most once.");
+
+  using key_t     = detail::args_key_t<Args...>;
+  using val_t     = std::decay_t<R>;
+  using storage_t = detail::select_option_t<detail::storage_option, storage::local, Options...>;
+  using cache_t   = typename detail::storage_cache<storage_t, key_t, val_t, Size, detail::without_options_t<detail::storage_option, Options...>>::type;
+
+  static constexpr bool SHARED = !std::same_as<storage_t, storage::local>;
+
+  F f;
+
+  // NOTE: Memoization does not change the observable behavior of (the pure) `f`, hence the mutable cache.
+  mutable std::conditional_t<SHARED, std::shared_ptr<cache_t>, cache_t> cache;
+
+  [[nodiscard]] cache_t& cache_ref() const noexcept {
+    if constexpr (SHARED) {
+      return *cache;
+    } else {
+      return cache;
+    }
+  }
+
+public:
+  explicit memoized(F f_) : f{std::move(f_)} {
+    if constexpr (SHARED) {
+      cache = std::make_shared<cache_t>();
+    }
+  }
+
+  /// Call the memoized function.
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// auto add = memoize<16>([](int a, int b) { return a + b; });
+  ///
+  /// assert(add(17, 25) == 42);
+  /// assert(add(17, 25) == 42); // Cache hit.
+  /// ```
+  val_t operator()(Args... args) const {
+    const auto compute = [&](const auto&) -> val_t { return std::invoke(f, std::forward<Args>(args)...); };
+
+    // NOTE: The key is constructed from the arguments before `compute` runs, so it may move from them; except for unary
+    //       functions with local storage, where the argument itself is the key (inserted after `f` returns), and is passed
+    //       to `f` as an lvalue (or a copy).
+    if constexpr (SHARED) {
+      if constexpr (sizeof...(Args) == 1) {
+        return cache_ref().find_or_insert_with(key_t(args...), compute);
+      } else {
+        return cache_ref().find_or_insert_with(key_t(std::tuple<const std::decay_t<Args>&...>{args...}), compute);
+      }
+    } else if constexpr (sizeof...(Args) == 1) {
+      return cache_ref().find_or_insert_with(args..., [&](const key_t& key) -> val_t {
+        if constexpr (std::is_invocable_v<const F&, const key_t&>) {
+          return std::invoke(f, key);
+        } else {
+          auto arg = key; // E.g. for rvalue reference parameters.
+          return std::invoke(f, static_cast<Args&&>(arg)...);
+        }
+      });
+    } else {
+      return cache_ref().find_or_insert_with(std::tuple<const std::decay_t<Args>&...>{args...}, compute);
+    }
+  }
+
+  /// Clear the cache (of all copies, with shared storage).
+  ///
+  /// # Examples
+  ///
+  /// ```
+  /// #include <cassert>
+  /// #include <memo_cache.hpp>
+  ///
+  /// auto add = memoize<16>([](int a, int b) { return a + b; });
+  ///
+  /// assert(add(17, 25) == 42);
+  ///
+  /// add.clear();
   /// ```
   void clear() {
-    buffer = {};
+    cache_ref().clear();
   }
 };
 
+/// Memoize the function `f` using a cache of `Size` entries, with the given cache and storage options. The signature of
+/// `f` must be unambiguous (i.e. a function (pointer), or a class with a single, non-template call operator); use
+/// `memoized` directly otherwise.
+///
+/// # Examples
+///
+/// ```
+/// #include <cassert>
+/// #include <memo_cache.hpp>
+///
+/// float calculate(int input, float scale);
+///
+/// const auto memoized_calculate = memoize<64, mc::policy::lru>(&calculate);
+///
+/// assert(memoized_calculate(17, 2.5f) == calculate(17, 2.5f));
+/// ```
+template<std::size_t Size, typename... Options, typename F>
+[[nodiscard]] auto memoize(F f) {
+  return memoized<F, detail::signature_of_t<F>, Size, Options...>{std::move(f)};
+}
+
 } // namespace v1
 
 } // namespace mc
+
+/// Hash for the cache keys of memoized functions with more than one parameter, combining the hashes of the arguments.
+template<typename... Ts>
+struct std::hash<mc::detail::args_key<Ts...>> {
+  std::size_t operator()(const mc::detail::args_key<Ts...>& key) const {
+    return std::apply(
+        [](const auto&... values) {
+          std::uint64_t h{};
+          ((h = mc::detail::mix_hash(h + static_cast<std::uint64_t>(std::hash<std::decay_t<decltype(values)>>{}(values)))), ...);
+          return static_cast<std::size_t>(h);
+        },
+        key.values);
+  }
+};
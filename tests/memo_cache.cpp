@@ -3,8 +3,256 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#if defined(MC_SHARED_MEMORY)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// A key type that counts its constructions from string views, and its comparisons.
+struct tracked_key {
+  static inline int conversions = 0;
+  static inline int comparisons = 0;
+
+  std::string value;
+
+  tracked_key() = default;
+  explicit tracked_key(std::string_view v) : value{v} { ++conversions; }
+
+  bool operator==(const tracked_key& other) const {
+    ++comparisons;
+    return value == other.value;
+  }
+
+  bool operator==(std::string_view v) const {
+    ++comparisons;
+    return value == v;
+  }
+};
+
+/// A value type that counts its copies and moves.
+struct tracked_value {
+  static inline int copies = 0;
+  static inline int moves  = 0;
+
+  int value{};
+
+  tracked_value() = default;
+  explicit tracked_value(int v) noexcept : value{v} {}
+  tracked_value(const tracked_value& other) noexcept : value{other.value} { ++copies; }
+  tracked_value(tracked_value&& other) noexcept : value{other.value} { ++moves; }
+
+  tracked_value& operator=(const tracked_value& other) noexcept {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+
+  tracked_value& operator=(tracked_value&& other) noexcept {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+
+  bool operator==(const tracked_value&) const = default;
+};
+
+/// A key type without a default constructor, that counts its live instances.
+struct counted_key {
+  static inline int instances = 0;
+
+  int value;
+
+  explicit counted_key(int v) noexcept : value{v} { ++instances; }
+  counted_key(const counted_key& other) noexcept : value{other.value} { ++instances; }
+  counted_key& operator=(const counted_key&) = default;
+  ~counted_key() { --instances; }
+
+  bool operator==(const counted_key&) const = default;
+};
+
+/// A key type that can only be moved.
+struct move_only_key {
+  int value;
+
+  explicit move_only_key(int v) noexcept : value{v} {}
+  move_only_key(move_only_key&&) noexcept            = default;
+  move_only_key& operator=(move_only_key&&) noexcept = default;
+
+  bool operator==(const move_only_key&) const = default;
+};
+
+/// A clock that only advances when told to.
+struct manual_clock {
+  using rep        = std::int64_t;
+  using period     = std::milli;
+  using duration   = std::chrono::duration<rep, period>;
+  using time_point = std::chrono::time_point<manual_clock>;
+
+  static constexpr bool is_steady = true;
+
+  static inline time_point current{};
+
+  static time_point now() noexcept {
+    return current;
+  }
+
+  static void advance(duration d) noexcept {
+    current += d;
+  }
+};
+
+/// A memory resource that counts its allocations.
+class counting_resource : public std::pmr::memory_resource {
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+public:
+  int allocations = 0;
+};
+
+/// Weighs cache entries by the length of their string value.
+struct string_length {
+  std::size_t operator()(const auto&, const std::string& s) const noexcept {
+    return s.size();
+  }
+};
+
+/// Fibonacci numbers, memoized (only feasible in constant evaluation with memoization).
+template<typename Cache>
+constexpr std::uint64_t fibonacci(Cache& cache, int n) {
+  if (n < 2) {
+    return static_cast<std::uint64_t>(n);
+  }
+
+  if (const auto v = cache.find(n)) {
+    return *v;
+  }
+
+  const auto result = fibonacci(cache, n - 1) + fibonacci(cache, n - 2);
+  cache.insert(n, result);
+
+  return result;
+}
+
+template<typename... Options>
+consteval std::uint64_t compile_time_fibonacci(int n) {
+  mc::memo_cache<int, std::uint64_t, 128, Options...> cache;
+  return fibonacci(cache, n);
+}
+
+/// Exercises the cache API in constant evaluation.
+template<typename... Options>
+consteval bool compile_time_api() {
+  mc::memo_cache<int, int, 2, Options...> c;
+
+  c.insert(1, 10);
+  c.insert(2, 20);
+
+  const bool found = c.contains(1) && c.find(2).value() == 20 && !c.contains(3);
+
+  const auto v = c.find_or_insert_with(3, [](int k) { return k * 10; }).get(); // Evicts key 1.
+  const bool evicted = !c.contains(1) && c.contains(2) && v == 30;
+
+  c.clear();
+
+  return found && evicted && !c.contains(2) && !c.contains(3);
+}
+
+/// A coroutine that starts eagerly, and runs detached.
+struct spawned {
+  struct promise_type {
+    spawned get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+/// Simulated asynchronous I/O: reads suspend until completed by the test. Negative results are I/O errors.
+struct io_queue {
+  struct request {
+    int                     key{};
+    int*                    result{};
+    std::coroutine_handle<> handle;
+  };
+
+  std::deque<request> requests;
+
+  struct read_awaitable {
+    io_queue& queue;
+    int       key;
+    int       result{};
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { queue.requests.push_back({key, &result, h}); }
+    int await_resume() const {
+      if (result < 0) {
+        throw std::runtime_error{"I/O error"};
+      }
+      return result;
+    }
+  };
+
+  read_awaitable read(int key) {
+    return {*this, key};
+  }
+
+  /// Complete all pending reads, with the result `f(key)`.
+  template<typename F>
+  void complete_all(F f) {
+    while (!requests.empty()) {
+      const auto r = requests.front();
+      requests.pop_front();
+      *r.result = f(r.key);
+      r.handle.resume();
+    }
+  }
+};
+
+} // namespace
+
+template<>
+struct std::hash<tracked_key> {
+  std::size_t operator()(const tracked_key& k) const noexcept {
+    return std::hash<std::string>{}(k.value);
+  }
+};
 
 TEST_SUITE("memo_cache")
 {
@@ -92,6 +340,43 @@ TEST_SUITE("memo_cache")
     CHECK_FALSE(c.find("hello").has_value());
   }
 
+  TEST_CASE("clear and purge")
+  {
+    const auto owner = std::make_shared<int>(42);
+
+    const auto check = [&owner](auto& c) {
+      for (int i = 0; i < 4; ++i) {
+        c.insert(i, owner);
+      }
+
+      // Clearing leaves the values in place, until their slots are filled again.
+      c.clear();
+
+      CHECK_FALSE(c.contains(0));
+      CHECK_EQ(owner.use_count(), 5);
+
+      c.insert(0, std::make_shared<int>(17));
+      CHECK_EQ(*c.find(0)->get(), 17);
+      CHECK_FALSE(c.contains(1));
+      CHECK_EQ(owner.use_count(), 4);
+
+      c.purge();
+
+      CHECK_FALSE(c.contains(0));
+      CHECK_EQ(owner.use_count(), 1);
+    };
+
+    mc::memo_cache<int, std::shared_ptr<int>, 4, mc::layout::aos> aos;
+    mc::memo_cache<int, std::shared_ptr<int>, 4, mc::layout::soa> soa;
+    mc::memo_cache<int, std::shared_ptr<int>, 4, mc::layout::fingerprinted<>> fingerprinted;
+    mc::dynamic_memo_cache<int, std::shared_ptr<int>> dynamic{4};
+
+    check(aos);
+    check(soa);
+    check(fingerprinted);
+    check(dynamic);
+  }
+
   TEST_CASE("Empty cache")
   {
     mc::memo_cache<bool, bool, 2> c;
@@ -181,17 +466,2148 @@ TEST_SUITE("memo_cache")
     CHECK_EQ(c.find(KV1.first).value(), KV1.second);
   }
 
-  TEST_CASE("Static type properties")
+  TEST_CASE("Scannable keys")
   {
-    using Cache = mc::memo_cache<std::string, std::string, 8>;
+    enum class Color : std::uint8_t { Red, Green, Blue };
 
-    // The cache is semiregular:
-    static_assert(std::is_constructible_v<Cache>);
-    static_assert(std::is_default_constructible_v<Cache>);
-    static_assert(std::is_copy_assignable_v<Cache>);
-    static_assert(std::is_copy_constructible_v<Cache>);
-    static_assert(std::is_move_assignable_v<Cache>);
-    static_assert(std::is_move_constructible_v<Cache>);
+    // Every lane width is covered, and (odd) sizes that exceed a single vector and a single scan block.
+    const auto check_keys = [](auto c, auto make_key) {
+      CHECK_FALSE(c.contains(make_key(0)));
+
+      for (int i = 0; i < static_cast<int>(c.size()); ++i) {
+        c.insert(make_key(i), i);
+      }
+
+      for (int i = 0; i < static_cast<int>(c.size()); ++i) {
+        REQUIRE(c.find(make_key(i)).has_value());
+        CHECK_EQ(c.find(make_key(i)).value(), i);
+      }
+
+      // Overwriting the oldest element should evict it (and only it).
+      c.insert(make_key(static_cast<int>(c.size())), -1);
+
+      CHECK_FALSE(c.contains(make_key(0)));
+      CHECK(c.contains(make_key(1)));
+      CHECK(c.contains(make_key(static_cast<int>(c.size()))));
+    };
+
+    check_keys(mc::memo_cache<std::uint8_t, int, 5>{}, [](int i) { return static_cast<std::uint8_t>(i); });
+    check_keys(mc::memo_cache<char, int, 37>{}, [](int i) { return static_cast<char>(i); });
+    check_keys(mc::memo_cache<std::int16_t, int, 77>{}, [](int i) { return static_cast<std::int16_t>(-i); });
+    check_keys(mc::memo_cache<int, int, 131>{}, [](int i) { return i * 7; });
+    check_keys(mc::memo_cache<std::uint64_t, int, 300>{}, [](int i) { return static_cast<std::uint64_t>(i) * 0x9E37'79B9'7F4A'7C15ULL; });
+    check_keys(mc::memo_cache<Color, int, 3>{}, [](int i) { return static_cast<Color>(i); });
+
+    static const std::array<int, 10> OBJECTS{};
+    check_keys(mc::memo_cache<const int*, int, 9>{}, [](int i) { return &OBJECTS.at(static_cast<std::size_t>(i)); });
+  }
+
+  TEST_CASE("Scannable keys: empty slots")
+  {
+    mc::memo_cache<int, int, 100> c;
+
+    // NOTE: Unoccupied slots hold value-initialized keys, which should never produce a match.
+    CHECK_FALSE(c.contains(0));
+
+    c.insert(0, 42);
+
+    REQUIRE(c.find(0).has_value());
+    CHECK_EQ(c.find(0).value(), 42);
+
+    c.clear();
+
+    CHECK_FALSE(c.contains(0));
+  }
+
+  TEST_CASE("Layouts")
+  {
+    const auto check_layout = [](auto&& c, auto make_key) {
+      CHECK_FALSE(c.contains(make_key(1)));
+
+      c.insert(make_key(1), 17);
+      c.insert(make_key(2), 19);
+      c.insert(make_key(3), 23);
+
+      REQUIRE(c.find(make_key(1)).has_value());
+      CHECK_EQ(c.find(make_key(1)).value(), 17);
+
+      c.insert(make_key(1), 29); // Overwrite.
+
+      CHECK_EQ(c.find(make_key(1)).value(), 29);
+
+      c.insert(make_key(4), 31); // Evicts the oldest key.
+
+      CHECK_FALSE(c.contains(make_key(1)));
+      CHECK_EQ(c.find(make_key(2)).value(), 19);
+      CHECK_EQ(c.find(make_key(4)).value(), 31);
+
+      c.clear();
+
+      CHECK_FALSE(c.contains(make_key(2)));
+      CHECK_FALSE(c.contains(make_key(4)));
+    };
+
+    const auto int_key    = [](int i) { return i; };
+    const auto string_key = [](int i) { return std::to_string(i); };
+
+    check_layout(mc::memo_cache<int, int, 3, mc::layout::aos>{}, int_key);
+    check_layout(mc::memo_cache<int, int, 3, mc::layout::soa>{}, int_key);
+    check_layout(mc::memo_cache<int, int, 3, mc::layout::automatic>{}, int_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::aos>{}, string_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::soa>{}, string_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::automatic>{}, string_key);
+    check_layout(mc::memo_cache<int, int, 3, mc::layout::fingerprinted<>>{}, int_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::fingerprinted<>>{}, string_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::fingerprinted<std::uint64_t>>{}, string_key);
+    check_layout(mc::memo_cache<int, int, 3, mc::layout::aligned>{}, int_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::aligned>{}, string_key);
+    check_layout(mc::memo_cache<int, int, 3, mc::probe::recent>{}, int_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::probe::recent>{}, string_key);
+    check_layout(mc::memo_cache<std::string, int, 3, mc::layout::fingerprinted<>, mc::probe::recent>{}, string_key);
+
+    // Aligned slots are padded to whole cache lines, and the rest of the cache starts on a cache line of its own.
+    using mid_key = std::array<std::uint64_t, 3>;
+    static_assert(alignof(mc::memo_cache<mid_key, int, 8, mc::layout::aligned>) == 64);
+    static_assert(sizeof(mc::memo_cache<mid_key, int, 8, mc::layout::aligned>) == 8 * 64 + 64 + 64);
+  }
+
+  TEST_CASE("Eviction policies")
+  {
+    // Invariants for every policy: all slots are used, and found values are always the most recently inserted ones.
+    const auto check_policy = [](auto&& c) {
+      for (int i = 0; i < static_cast<int>(c.size()); ++i) {
+        c.insert(i, i);
+      }
+
+      for (int i = 0; i < static_cast<int>(c.size()); ++i) {
+        REQUIRE(c.contains(i));
+      }
+
+      std::unordered_map<int, int> model;
+
+      std::mt19937                       generator{42}; // NOLINT: Deterministic.
+      std::uniform_int_distribution<int> distribution{0, 3 * static_cast<int>(c.size())};
+
+      for (int n = 0; n < 10'000; ++n) {
+        const auto k = distribution(generator);
+
+        if (n % 3 == 0) {
+          c.insert(k, n);
+          model[k] = n;
+          REQUIRE_EQ(c.find(k).value(), n);
+        } else if (const auto found = c.find(k); found) {
+          CHECK_EQ(found->get(), model.contains(k) ? model.at(k) : k);
+        }
+      }
+
+      int count = 0;
+      for (int k = 0; k <= 3 * static_cast<int>(c.size()); ++k) {
+        count += c.contains(k) ? 1 : 0;
+      }
+
+      CHECK_EQ(count, static_cast<int>(c.size()));
+
+      c.clear();
+
+      for (int i = 0; i < static_cast<int>(c.size()); ++i) {
+        c.insert(-i - 1, i);
+      }
+
+      for (int i = 0; i < static_cast<int>(c.size()); ++i) {
+        REQUIRE(c.contains(-i - 1));
+      }
+    };
+
+    check_policy(mc::memo_cache<int, int, 1, mc::policy::fifo>{});
+    check_policy(mc::memo_cache<int, int, 1, mc::policy::clock>{});
+    check_policy(mc::memo_cache<int, int, 1, mc::policy::sieve>{});
+    check_policy(mc::memo_cache<int, int, 1, mc::policy::s3fifo>{});
+    check_policy(mc::memo_cache<int, int, 1, mc::policy::lru>{});
+
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::fifo>{});
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::clock>{});
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::sieve>{});
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::s3fifo>{});
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::lru, mc::layout::aos>{});
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::clock, mc::layout::aligned>{});
+    check_policy(mc::memo_cache<int, int, 77, mc::policy::lru, mc::layout::aos, mc::probe::recent>{});
+  }
+
+  TEST_CASE("Eviction policies: retention")
+  {
+    // Insert three keys, hit the first one, and insert two more keys.
+    const auto retained = [](auto c) {
+      c.insert(1, 1);
+      c.insert(2, 2);
+      c.insert(3, 3);
+
+      CHECK(c.find(1).has_value());
+
+      c.insert(4, 4);
+      c.insert(5, 5);
+
+      std::vector<int> result;
+      for (int k = 1; k <= 5; ++k) {
+        if (c.contains(k)) {
+          result.push_back(k);
+        }
+      }
+
+      return result;
+    };
+
+    CHECK_EQ(retained(mc::memo_cache<int, int, 3, mc::policy::fifo>{}), std::vector{3, 4, 5});
+    CHECK_EQ(retained(mc::memo_cache<int, int, 3, mc::policy::clock>{}), std::vector{1, 4, 5});
+    CHECK_EQ(retained(mc::memo_cache<int, int, 3, mc::policy::sieve>{}), std::vector{1, 4, 5});
+    CHECK_EQ(retained(mc::memo_cache<int, int, 3, mc::policy::lru>{}), std::vector{1, 4, 5});
+  }
+
+  TEST_CASE("Eviction policies: scan resistance")
+  {
+    // Hot keys (that are hit) survive a scan of one-hit wonders, unlike with FIFO retention.
+    const auto hot_keys_retained = [](auto c) {
+      for (int k = 0; k < 10; ++k) {
+        c.insert(k, k);
+      }
+
+      for (int k = 0; k < 5; ++k) {
+        CHECK(c.find(k).has_value());
+      }
+
+      for (int k = 100; k < 200; ++k) {
+        c.insert(k, k);
+      }
+
+      return c.contains(0) && c.contains(1) && c.contains(2) && c.contains(3) && c.contains(4);
+    };
+
+    CHECK_FALSE(hot_keys_retained(mc::memo_cache<int, int, 10, mc::policy::fifo>{}));
+    CHECK(hot_keys_retained(mc::memo_cache<int, int, 10, mc::policy::s3fifo>{}));
+  }
+
+  TEST_CASE("Fingerprinted layout")
+  {
+    // Count key comparisons for a hit and a miss in a full cache.
+    const auto comparisons = [](auto c) {
+      for (int i = 0; i < 100; ++i) {
+        c.insert(tracked_key{std::to_string(i)}, i);
+      }
+
+      tracked_key::comparisons = 0;
+
+      CHECK_EQ(c.find(tracked_key{"42"}).value(), 42);
+      CHECK_FALSE(c.contains(tracked_key{"hello"}));
+
+      return tracked_key::comparisons;
+    };
+
+    CHECK_GE(comparisons(mc::memo_cache<tracked_key, long, 100, mc::layout::aos>{}), 100);
+    CHECK_EQ(comparisons(mc::memo_cache<tracked_key, long, 100, mc::layout::fingerprinted<std::uint64_t>>{}), 1);
+
+    // Heterogeneous lookups and overwrites still find their keys.
+    mc::memo_cache<std::string, int, 70, mc::layout::fingerprinted<>> c;
+
+    for (int i = 0; i < 70; ++i) {
+      c.insert(std::to_string(i), i);
+    }
+
+    c.insert("69", 17);
+
+    CHECK_EQ(c.find("69").value(), 17);
+    CHECK_EQ(c.find(std::string_view{"0"}).value(), 0);
+    CHECK_EQ(c.find_ptr(std::string{"68"}), &c.find("68").value().get());
+    CHECK(c.emplace_or_assign("70", 71).second);
+    CHECK_FALSE(c.contains("0"));
+  }
+
+  TEST_CASE("Heterogeneous lookup")
+  {
+    mc::memo_cache<tracked_key, int, 4> c;
+
+    c.insert(tracked_key{"hello"}, 42);
+
+    tracked_key::conversions = 0;
+
+    REQUIRE(c.find(std::string_view{"hello"}).has_value());
+    CHECK_EQ(c.find(std::string_view{"hello"}).value(), 42);
+    CHECK(c.contains(std::string_view{"hello"}));
+    CHECK_FALSE(c.contains(std::string_view{"hi"}));
+
+    CHECK_EQ(c.find_or_insert_with(std::string_view{"hello"}, [](const tracked_key&) { return 17; }), 42);
+
+    CHECK_EQ(tracked_key::conversions, 0);
+
+    // Keys are only constructed for insertion.
+    CHECK_EQ(c.find_or_insert_with(std::string_view{"hi"}, [](const tracked_key& k) { return static_cast<int>(k.value.size()); }), 2);
+
+    CHECK_EQ(tracked_key::conversions, 1);
+    CHECK(c.contains(std::string_view{"hi"}));
+
+    // Standard string keys, looked up by string views, C strings and string literals.
+    mc::memo_cache<std::string, int, 4> s;
+
+    s.insert("hello", 42);
+
+    const char* hello = "hello";
+
+    CHECK_EQ(s.find(std::string_view{"hello"}).value(), 42);
+    CHECK_EQ(s.find(hello).value(), 42);
+    CHECK_EQ(s.find("hello").value(), 42);
+    CHECK_FALSE(s.contains(std::string_view{"hell"}));
+
+    // Scannable keys looked up by another integral type, which is compared by value.
+    mc::memo_cache<std::int8_t, int, 4> i;
+
+    i.insert(std::int8_t{-1}, 42);
+
+    CHECK(i.contains(-1));
+    CHECK(i.contains(-1L));
+    CHECK_FALSE(i.contains(255));
+  }
+
+  TEST_CASE("find_ptr")
+  {
+    mc::memo_cache<std::string, int, 3> c;
+
+    CHECK_EQ(c.find_ptr("hello"), nullptr);
+
+    c.insert("hello", 42);
+
+    auto* v = c.find_ptr("hello");
+
+    REQUIRE_NE(v, nullptr);
+    CHECK_EQ(*v, 42);
+
+    *v = 17;
+
+    CHECK_EQ(c.find("hello").value(), 17);
+    CHECK_EQ(c.find_ptr(std::string_view{"hello"}), v);
+  }
+
+  TEST_CASE("Const lookup does not count as a hit")
+  {
+    const auto evicted = [](auto c, bool peek) {
+      c.insert(1, 1);
+      c.insert(2, 2);
+
+      if (peek) {
+        const auto& cc = c;
+        CHECK_EQ(cc.find(1).value(), 1);
+        CHECK_EQ(*cc.find_ptr(1), 1);
+      } else {
+        CHECK(c.find(1).has_value());
+      }
+
+      c.insert(3, 3);
+
+      return c.contains(1) ? 2 : 1;
+    };
+
+    CHECK_EQ(evicted(mc::memo_cache<int, int, 2, mc::policy::lru>{}, false), 2);
+    CHECK_EQ(evicted(mc::memo_cache<int, int, 2, mc::policy::lru>{}, true), 1);
+  }
+
+  TEST_CASE("try_emplace and emplace_or_assign")
+  {
+    const auto check_emplace = [](auto c) {
+      tracked_value::copies = 0;
+      tracked_value::moves  = 0;
+
+      {
+        auto [v, inserted] = c.try_emplace(1, 17);
+
+        CHECK(inserted);
+        CHECK_EQ(v.value, 17);
+      }
+
+      {
+        auto [v, inserted] = c.try_emplace(1, 19);
+
+        CHECK_FALSE(inserted);
+        CHECK_EQ(v.value, 17);
+      }
+
+      {
+        auto [v, inserted] = c.emplace_or_assign(1, 23);
+
+        CHECK_FALSE(inserted);
+        CHECK_EQ(v.value, 23);
+      }
+
+      CHECK(c.emplace_or_assign(2, 29).second);
+      CHECK_EQ(c.find(2).value().get().value, 29);
+
+      // Values are constructed in the slots, never copied or moved.
+      CHECK_EQ(tracked_value::copies, 0);
+      CHECK_EQ(tracked_value::moves, 0);
+
+      // Inserting a value moves it into its slot exactly once.
+      c.insert(3, tracked_value{31});
+
+      CHECK_EQ(tracked_value::copies, 0);
+      CHECK_EQ(tracked_value::moves, 1);
+
+      // Evicts key 1.
+      CHECK(c.try_emplace(4, 37).second);
+      CHECK_FALSE(c.contains(1));
+      CHECK_EQ(c.find(4).value().get().value, 37);
+    };
+
+    check_emplace(mc::memo_cache<int, tracked_value, 3, mc::layout::aos>{});
+    check_emplace(mc::memo_cache<int, tracked_value, 3, mc::layout::soa>{});
+  }
+
+  TEST_CASE("Batch lookup")
+  {
+    mc::memo_cache<int, int, 8> c;
+
+    c.insert(1, 10);
+    c.insert(2, 20);
+
+    const std::vector keys{1, 3, 2, 3, 4};
+
+    std::vector<int*> found(keys.size());
+
+    CHECK_EQ(c.find_many(keys, found), 2);
+    REQUIRE_NE(found[0], nullptr);
+    CHECK_EQ(*found[0], 10);
+    CHECK_EQ(found[1], nullptr);
+    CHECK_EQ(*found[2], 20);
+
+    int              calls = 0;
+    std::vector<int> out(keys.size());
+
+    const auto compute = [&calls](std::span<const int> misses, std::span<int> vals) {
+      ++calls;
+
+      REQUIRE_EQ(misses.size(), vals.size());
+      for (std::size_t i = 0; i < misses.size(); ++i) {
+        vals[i] = misses[i] * 10;
+      }
+
+      return misses.size();
+    };
+
+    c.find_or_insert_many(keys, out, compute);
+
+    CHECK_EQ(out, std::vector{10, 30, 20, 30, 40});
+    CHECK_EQ(calls, 1);
+    CHECK(c.contains(3));
+    CHECK(c.contains(4));
+
+    // All hits: not computed.
+    c.find_or_insert_many(keys, out, compute);
+
+    CHECK_EQ(calls, 1);
+
+    // More misses than the cache size: all values are returned, and the last ones are retained.
+    std::vector<int> many(20);
+    std::iota(many.begin(), many.end(), 100);
+    std::vector<int> many_out(many.size());
+
+    c.find_or_insert_many(many, many_out, compute);
+
+    CHECK_EQ(calls, 2);
+    CHECK_EQ(many_out[0], 1000);
+    CHECK_EQ(many_out[19], 1190);
+    CHECK_FALSE(c.contains(100));
+    CHECK(c.contains(119));
+
+    // Distinct misses are passed in order of first occurrence, whether or not the keys are ordered.
+    const auto check_misses = [](auto&& d, const auto& batch, const auto& expected) {
+      std::vector<int> batch_out(batch.size());
+
+      d.find_or_insert_many(batch, batch_out, [&expected](auto misses, std::span<int> vals) {
+        CHECK(std::ranges::equal(misses, expected));
+        for (std::size_t i = 0; i < misses.size(); ++i) {
+          vals[i] = static_cast<int>(i);
+        }
+      });
+
+      CHECK_EQ(batch_out, std::vector{0, 1, 2, 1, 0, 2});
+    };
+
+    check_misses(mc::memo_cache<int, int, 8>{}, std::vector{5, 9, 6, 9, 5, 6}, std::vector{5, 9, 6});
+    check_misses(mc::memo_cache<counted_key, int, 8>{},
+                 std::vector{counted_key{5}, counted_key{9}, counted_key{6}, counted_key{9}, counted_key{5}, counted_key{6}},
+                 std::vector{counted_key{5}, counted_key{9}, counted_key{6}});
+  }
+
+  TEST_CASE("Expiry")
+  {
+    using namespace std::chrono_literals;
+
+    mc::memo_cache<int, int, 4, mc::expiry::ttl<manual_clock>> c;
+
+    // Entries do not expire until a time to live is set.
+    c.insert(1, 10);
+    manual_clock::advance(1'000'000s);
+
+    CHECK(c.contains(1));
+
+    c.set_time_to_live(10s);
+    c.insert(2, 20);
+    c.insert(3, 30, 2s); // Per entry.
+
+    manual_clock::advance(5s);
+
+    CHECK(c.contains(1));
+    CHECK(c.contains(2));
+    CHECK_FALSE(c.contains(3));
+    CHECK_FALSE(c.find(3).has_value());
+    CHECK_EQ(c.find_ptr(3), nullptr);
+
+    manual_clock::advance(5s);
+
+    CHECK(c.contains(1));
+    CHECK_FALSE(c.contains(2));
+
+    // Expired entries are refreshed in place, rather than inserted again.
+    c.insert(2, 21);
+
+    CHECK_EQ(c.find(2).value(), 21);
+    CHECK_EQ(c.find_or_insert_with(3, [](int k) { return k * 11; }), 33);
+    CHECK(c.try_emplace(3, 34).second == false);
+
+    manual_clock::advance(10s);
+
+    CHECK(c.try_emplace(3, 35).second);
+    CHECK_EQ(c.find(3).value(), 35);
+    CHECK(c.emplace_or_assign(2, 22).second);
+    CHECK_EQ(c.find(2).value(), 22);
+
+    c.insert(4, 40);
+    c.insert(5, 50); // Evicts key 1, as usual.
+
+    CHECK_FALSE(c.contains(1));
+
+    c.clear();
+
+    CHECK_FALSE(c.contains(2));
+
+    // Millisecond ticks span 49 days; the epoch moves along, so the cache keeps working for any uptime.
+    mc::memo_cache<int, int, 4, mc::expiry::ttl<manual_clock, std::chrono::milliseconds>> m;
+    m.insert(1, 10); // Never expires.
+    m.set_time_to_live(10s);
+    m.insert(2, 20, std::chrono::hours{24 * 30});
+
+    for (int day = 1; day <= 100; ++day) {
+      manual_clock::advance(24h);
+      m.insert(3, day);
+
+      if (day == 40) {
+        m.insert(4, 40, std::chrono::hours{24 * 20}); // Lives across the first rebase, after 49 days.
+      }
+
+      CHECK(m.contains(1));
+      CHECK(m.contains(3));
+      CHECK_EQ(m.contains(2), day < 30);
+      CHECK_EQ(m.contains(4), day >= 40 && day < 60);
+    }
+
+    manual_clock::advance(9s);
+    CHECK(m.contains(3));
+    manual_clock::advance(1s);
+    CHECK_FALSE(m.contains(3));
+
+    // Without expiry, there is no per-slot state at all.
+    static_assert(sizeof(mc::memo_cache<int, int, 8>) == sizeof(mc::memo_cache<int, int, 8, mc::expiry::none>));
+    static_assert(sizeof(mc::memo_cache<int, int, 8, mc::expiry::ttl<>>) > sizeof(mc::memo_cache<int, int, 8>));
+  }
+
+  TEST_CASE("Statistics")
+  {
+    mc::memo_cache<int, int, 4, mc::stats::counters> c;
+
+    std::vector<std::pair<int, int>> evicted;
+    c.set_eviction_hook([&evicted](const int& k, const int& v) { evicted.emplace_back(k, v); });
+
+    for (int i = 0; i < 4; ++i) {
+      c.insert(i, i * 10);
+    }
+
+    c.insert(0, 1);              // Overwrite.
+    CHECK(c.contains(3));        // Hit, scanning all four slots.
+    CHECK_FALSE(c.contains(17)); // Miss, scanning all four slots.
+    CHECK_EQ(c.find_or_insert_with(5, [](int k) { return k; }), 5); // Miss, evicting key 0.
+    CHECK(c.find(5).has_value()); // Hit, in the first slot.
+
+    const auto stats = c.statistics();
+
+    CHECK_EQ(stats.hits, 2);
+    CHECK_EQ(stats.misses, 2);
+    CHECK_EQ(stats.inserts, 5);
+    CHECK_EQ(stats.overwrites, 1);
+    CHECK_EQ(stats.evictions, 1);
+    CHECK_EQ(stats.probes, 4 + 4 + 4 + 1);
+    CHECK_EQ(stats.hit_ratio(), 0.5);
+    CHECK_EQ(evicted, std::vector<std::pair<int, int>>{{0, 1}});
+
+    c.reset_statistics();
+
+    CHECK_EQ(c.statistics(), mc::cache_stats{});
+
+    // Both "find or insert" calls count as lookups.
+    CHECK(c.try_emplace(7, 70).second);             // Miss.
+    CHECK_FALSE(c.try_emplace(7, 71).second);       // Hit.
+    CHECK(c.emplace_or_assign(8, 80).second);       // Miss.
+    CHECK_FALSE(c.emplace_or_assign(8, 81).second); // Hit.
+
+    CHECK_EQ(c.statistics().hits, 2);
+    CHECK_EQ(c.statistics().misses, 2);
+
+    // Without statistics, there is no state at all.
+    static_assert(sizeof(mc::memo_cache<int, int, 8>) == sizeof(mc::memo_cache<int, int, 8, mc::stats::none>));
+  }
+
+  TEST_CASE("Admission")
+  {
+    mc::memo_cache<int, int, 8, mc::admission::tinylfu> c;
+    mc::memo_cache<int, int, 8> unfiltered;
+
+    const auto touch = [](auto& cache, int k) { return cache.find_or_insert_with(k, [](int x) { return x * 10; }).get(); };
+
+    // A hot working set.
+    for (int round = 0; round < 8; ++round) {
+      for (int i = 0; i < 8; ++i) {
+        touch(c, i);
+        touch(unfiltered, i);
+      }
+    }
+
+    // A scan of one-off keys: the values are still computed, but the keys are not admitted.
+    for (int i = 1000; i < 1100; ++i) {
+      CHECK_EQ(touch(c, i), i * 10);
+      touch(unfiltered, i);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+      CHECK(c.contains(i));
+      CHECK_FALSE(unfiltered.contains(i));
+    }
+
+    CHECK_FALSE(c.contains(1099));
+
+    // A rejected entry is handed back, rather than taken for an evicted one (or lost).
+    const auto rejected = c.insert_and_take_evicted(2000, 7);
+    REQUIRE(rejected.has_value());
+    CHECK_EQ(*rejected, std::pair{2000, 7});
+    CHECK_FALSE(c.contains(2000));
+
+    // A new key is admitted once it is accessed more often than the victim.
+    for (int round = 0; round < 16 && !c.contains(42); ++round) {
+      touch(c, 42);
+    }
+
+    CHECK(c.contains(42));
+
+    // Empty slots are always filled.
+    c.clear();
+    c.insert(1234, 1);
+    CHECK(c.contains(1234));
+
+    // Without the filter, there is no state at all.
+    static_assert(sizeof(mc::memo_cache<int, int, 8>) == sizeof(mc::memo_cache<int, int, 8, mc::admission::always>));
+  }
+
+  TEST_CASE("Negative entries")
+  {
+    const auto check = [](auto&& c, auto make_key) {
+      auto owner = std::make_shared<int>(17);
+
+      int calls = 0;
+      const auto lookup = [&](const auto& k) -> std::optional<std::shared_ptr<int>> {
+        ++calls;
+        return (k == make_key(0)) ? std::optional{owner} : std::nullopt;
+      };
+
+      // Negative outcomes are memoized too.
+      CHECK_FALSE(c.find_or_insert_optional(make_key(1), lookup).has_value());
+      CHECK_FALSE(c.find_or_insert_optional(make_key(1), lookup).has_value());
+      CHECK_EQ(calls, 1);
+      CHECK(c.contains_negative(make_key(1)));
+      CHECK_FALSE(c.contains(make_key(1)));
+      CHECK_FALSE(c.find(make_key(1)).has_value());
+
+      CHECK_EQ(c.find_or_insert_optional(make_key(0), lookup)->get(), owner);
+      CHECK_EQ(calls, 2);
+      CHECK_EQ(owner.use_count(), 2);
+
+      // A negative entry releases the value, and a value replaces a negative entry.
+      c.insert_negative(make_key(0));
+      CHECK_EQ(owner.use_count(), 1);
+      CHECK_FALSE(c.contains(make_key(0)));
+
+      c.insert(make_key(1), owner);
+      CHECK_EQ(*c.find(make_key(1))->get(), 17);
+      CHECK_FALSE(c.contains_negative(make_key(1)));
+
+      // Negative entries are skipped when iterating, and evicted like others.
+      int values = 0;
+      c.for_each([&values](const auto&, const auto&) { ++values; });
+      CHECK_EQ(values, 1);
+
+      for (int i = 2; i < 6; ++i) {
+        c.insert_negative(make_key(i));
+      }
+
+      CHECK_FALSE(c.contains_negative(make_key(0)));
+      CHECK_FALSE(c.contains(make_key(1)));
+      CHECK(c.contains_negative(make_key(5)));
+
+      // Inserting over a negative entry does not duplicate the key.
+      c.try_emplace(make_key(5), owner);
+      CHECK_EQ(c.find(make_key(5))->get(), owner);
+      CHECK_FALSE(c.contains_negative(make_key(5)));
+    };
+
+    const auto int_key    = [](int i) { return i; };
+    const auto string_key = [](int i) { return (i == 0) ? std::string{} : std::to_string(i); };
+
+    check(mc::memo_cache<int, std::shared_ptr<int>, 4, mc::layout::aos>{}, int_key);
+    check(mc::memo_cache<int, std::shared_ptr<int>, 4, mc::layout::soa>{}, int_key);
+    check(mc::memo_cache<std::string, std::shared_ptr<int>, 4>{}, string_key);
+    check(mc::memo_cache<std::string, std::shared_ptr<int>, 4, mc::layout::fingerprinted<>>{}, string_key);
+
+    // Negative entries may expire sooner.
+    mc::memo_cache<int, int, 4, mc::expiry::ttl<manual_clock, std::chrono::milliseconds>> t;
+    t.set_time_to_live(std::chrono::seconds{60});
+    t.set_negative_time_to_live(std::chrono::seconds{1});
+
+    t.insert(1, 10);
+    t.insert_negative(2);
+    t.insert_negative(3, std::chrono::seconds{120});
+
+    manual_clock::advance(std::chrono::seconds{2});
+
+    CHECK(t.contains(1));
+    CHECK_FALSE(t.contains_negative(2));
+    CHECK(t.contains_negative(3));
+    CHECK_EQ(t.find_or_insert_optional(2, [](int k) { return std::optional{k * 10}; })->get(), 20);
+
+    // A batch lookup does not insert a key twice over its negative entry.
+    mc::memo_cache<int, int, 4> b;
+    b.insert_negative(7);
+
+    std::array<int, 1> out{};
+    b.find_or_insert_many(std::array{7}, out, [](std::span<const int> misses, std::span<int> vals) { vals[0] = misses[0] * 2; });
+    CHECK_EQ(out[0], 14);
+    CHECK_EQ(b.find(7).value(), 14);
+
+    int count = 0;
+    b.for_each([&count](int, int) { ++count; });
+    CHECK_EQ(count, 1);
+  }
+
+  TEST_CASE("Probing")
+  {
+    mc::memo_cache<std::string, int, 64, mc::probe::recent, mc::stats::counters> c;
+
+    for (int i = 0; i < 64; ++i) {
+      c.insert(std::to_string(i), i);
+    }
+
+    const auto probes = [&c](std::string_view key) {
+      const auto before = c.statistics().probes;
+      CHECK(c.find(key).has_value());
+      return c.statistics().probes - before;
+    };
+
+    // Scans backwards from the newest key.
+    CHECK_EQ(probes("62"), 3);
+
+    // A repeated key is found at once.
+    CHECK_EQ(probes("10"), 1 + 54);
+    CHECK_EQ(probes("10"), 1);
+    CHECK_EQ(probes("10"), 1);
+
+    // The newest slot wraps around with the FIFO cursor.
+    c.insert("new", 64);
+    CHECK_FALSE(c.contains("0"));
+    CHECK_EQ(probes("new"), 1);
+    CHECK_EQ(probes("63"), 1 + 2);
+
+    // A miss probes every slot.
+    const auto before = c.statistics().probes;
+    CHECK_FALSE(c.find("missing").has_value());
+    CHECK_EQ(c.statistics().probes - before, 1 + 64);
+
+    c.clear();
+    CHECK_FALSE(c.contains("new"));
+    c.insert("0", 0);
+    CHECK_EQ(c.find("0").value(), 0);
+
+    // Without the option, there is no state at all.
+    static_assert(sizeof(mc::memo_cache<std::string, int, 64>) == sizeof(mc::memo_cache<std::string, int, 64, mc::probe::linear>));
+  }
+
+  TEST_CASE("Move-only types")
+  {
+    const auto check = [](auto&& c, auto make_key) {
+      c.insert(make_key(1), std::make_unique<int>(10));
+      CHECK_EQ(*c.find(make_key(1))->get(), 10);
+
+      const auto& v = c.find_or_insert_with(make_key(2), [](const auto&) { return std::make_unique<int>(20); }).get();
+      CHECK_EQ(*v, 20);
+
+      c.insert(make_key(1), std::make_unique<int>(11));
+      CHECK_EQ(*c.find(make_key(1))->get(), 11);
+
+      for (int i = 3; i <= 4; ++i) {
+        c.insert(make_key(i), std::make_unique<int>(i * 10));
+      }
+
+      auto evicted = c.insert_and_take_evicted(make_key(5), std::make_unique<int>(50));
+      REQUIRE(evicted.has_value());
+      CHECK_EQ(*evicted->second, 11);
+
+      // The cache moves, values included.
+      auto moved = std::move(c);
+      CHECK_EQ(*moved.find(make_key(5))->get(), 50);
+      CHECK_EQ(*moved.find(make_key(2))->get(), 20);
+
+      moved.purge();
+      CHECK_FALSE(moved.contains(make_key(5)));
+    };
+
+    const auto int_key    = [](int i) { return i; };
+    const auto string_key = [](int i) { return std::to_string(i); };
+
+    check(mc::memo_cache<int, std::unique_ptr<int>, 4, mc::layout::aos>{}, int_key);
+    check(mc::memo_cache<int, std::unique_ptr<int>, 4, mc::layout::soa>{}, int_key);
+    check(mc::memo_cache<std::string, std::unique_ptr<int>, 4>{}, string_key);
+    check(mc::memo_cache<std::string, std::unique_ptr<int>, 4, mc::layout::aligned>{}, string_key);
+    check(mc::memo_cache<std::string, std::unique_ptr<int>, 4, mc::layout::fingerprinted<>>{}, string_key);
+
+    static_assert(!std::is_copy_constructible_v<mc::memo_cache<int, std::unique_ptr<int>, 4>>);
+    static_assert(!std::is_copy_constructible_v<mc::memo_cache<std::string, std::unique_ptr<int>, 4>>);
+    static_assert(std::is_nothrow_move_constructible_v<mc::memo_cache<std::string, std::unique_ptr<int>, 4>>);
+
+    // Keys need not be default constructible, and are only constructed on insert.
+    {
+      mc::memo_cache<counted_key, int, 4> c;
+      CHECK_EQ(counted_key::instances, 0);
+
+      c.insert(counted_key{1}, 10);
+      c.insert(counted_key{2}, 20);
+      CHECK_EQ(counted_key::instances, 2);
+
+      auto copy = c;
+      CHECK_EQ(counted_key::instances, 4);
+      CHECK_EQ(copy.find(counted_key{2}), 20);
+
+      copy.purge();
+      CHECK_EQ(counted_key::instances, 2);
+    }
+
+    CHECK_EQ(counted_key::instances, 0);
+
+    // Keys need not be copyable either, not even to hand back an overwritten entry.
+    {
+      mc::memo_cache<move_only_key, std::unique_ptr<int>, 2> c;
+      c.insert(move_only_key{1}, std::make_unique<int>(10));
+
+      auto evicted = c.insert_and_take_evicted(move_only_key{1}, std::make_unique<int>(11));
+      REQUIRE(evicted.has_value());
+      CHECK_EQ(evicted->first, move_only_key{1});
+      CHECK_EQ(*evicted->second, 10);
+      CHECK_EQ(*c.find(move_only_key{1})->get(), 11);
+
+      c.insert(move_only_key{2}, std::make_unique<int>(20));
+      evicted = c.insert_and_take_evicted(move_only_key{3}, std::make_unique<int>(30));
+      REQUIRE(evicted.has_value());
+      CHECK_EQ(evicted->first, move_only_key{1});
+      CHECK_EQ(*evicted->second, 11);
+    }
+
+    // Values are destroyed with the cache, and copied with it.
+    auto owner = std::make_shared<int>(1);
+    {
+      mc::memo_cache<int, std::shared_ptr<int>, 4> c;
+      c.insert(1, owner);
+
+      const auto copy = c;
+      CHECK_EQ(owner.use_count(), 3);
+    }
+
+    CHECK_EQ(owner.use_count(), 1);
+  }
+
+  TEST_CASE("Take evicted")
+  {
+    const auto check = [](auto c, auto k1, auto k2) {
+      std::vector<int> v(100, 1);
+      const auto* storage = v.data();
+
+      CHECK_FALSE(c.insert_and_take_evicted(k1, std::move(v)).has_value());
+
+      // The evicted value is moved out, storage included.
+      auto evicted = c.insert_and_take_evicted(k2, std::vector<int>(100, 2));
+      REQUIRE(evicted.has_value());
+      CHECK_EQ(evicted->first, k1);
+      CHECK_EQ(evicted->second.data(), storage);
+      CHECK_FALSE(c.contains(k1));
+
+      // Overwriting a key hands back its previous value.
+      evicted->second.assign(50, 3);
+      evicted = c.insert_and_take_evicted(k2, std::move(evicted->second));
+      REQUIRE(evicted.has_value());
+      CHECK_EQ(evicted->first, k2);
+      CHECK_EQ(evicted->second, std::vector<int>(100, 2));
+      CHECK_EQ(c.find(k2)->get().data(), storage);
+      CHECK_EQ(c.find(k2)->get().size(), 50);
+    };
+
+    check(mc::memo_cache<std::string, std::vector<int>, 1>{}, std::string{"a"}, std::string{"b"});
+    check(mc::memo_cache<int, std::vector<int>, 1>{}, 1, 2);
+    check(mc::memo_cache<int, std::vector<int>, 1, mc::layout::fingerprinted<>>{}, 1, 2);
+  }
+
+  TEST_CASE("Weight budget")
+  {
+    mc::memo_cache<int, std::string, 8, mc::policy::greedy_dual_size<string_length, 100>, mc::stats::counters> c;
+
+    c.insert(1, std::string(40, 'a'));
+    c.insert(2, std::string(40, 'b'));
+    c.insert(3, std::string(10, 'c'));
+    CHECK_EQ(c.total_weight(), 90);
+
+    // Over budget: the oldest entry of the lowest priority goes.
+    c.insert(4, std::string(30, 'd'));
+    CHECK_FALSE(c.contains(1));
+    CHECK_EQ(c.total_weight(), 80);
+    CHECK_EQ(c.statistics().evictions, 1);
+
+    // Heavy entries go before light ones, even if the light ones are older.
+    c.insert(5, std::string(30, 'e'));
+    CHECK_FALSE(c.contains(2));
+    CHECK(c.contains(3));
+    CHECK_EQ(c.total_weight(), 70);
+
+    // Overwriting reweighs the entry.
+    c.insert(3, std::string(1, 'c'));
+    CHECK_EQ(c.total_weight(), 61);
+
+    // An entry heavier than the budget is kept, on its own.
+    CHECK_EQ(c.find_or_insert_with(6, [](int) { return std::string(150, 'f'); }).get().size(), 150);
+    CHECK_EQ(c.total_weight(), 150);
+
+    for (int i = 1; i < 6; ++i) {
+      CHECK_FALSE(c.contains(i));
+    }
+
+    // The evicted slots are filled again first, and only the heavy entry goes.
+    c.insert(7, std::string(10, 'g'));
+    CHECK_FALSE(c.contains(6));
+    CHECK(c.contains(7));
+
+    for (int i = 8; i < 15; ++i) {
+      c.insert(i, std::string(1, 'h'));
+    }
+
+    CHECK_EQ(c.total_weight(), 17);
+    CHECK(c.contains(7));
+
+    // A smaller budget takes effect immediately.
+    c.set_weight_budget(5);
+    CHECK_EQ(c.total_weight(), 5);
+    CHECK_FALSE(c.contains(7));
+
+    c.clear();
+    CHECK_EQ(c.total_weight(), 0);
+
+    // Without a budget, the policy only weighs what to evict.
+    mc::memo_cache<std::string, std::string, 2, mc::policy::greedy_dual_size<string_length>> u;
+
+    u.insert("light", std::string(1, 'x'));
+    u.insert("heavy", std::string(1000, 'x'));
+    u.insert("new", std::string(1, 'x'));
+    CHECK(u.contains("light"));
+    CHECK_FALSE(u.contains("heavy"));
+    CHECK_EQ(u.total_weight(), 2);
+  }
+
+  TEST_CASE("Snapshots")
+  {
+    using Cache = mc::memo_cache<int, int, 4, mc::policy::fifo>;
+
+    const auto path = std::filesystem::temp_directory_path() / "memo_cache_snapshot.bin";
+
+    Cache c;
+    for (int i = 0; i < 6; ++i) {
+      c.insert(i, i * 10);
+    }
+
+    REQUIRE(c.save(path));
+
+    Cache d;
+    REQUIRE(d.load(path));
+
+    for (int i = 2; i < 6; ++i) {
+      CHECK_EQ(d.find(i), i * 10);
+    }
+
+    // The retention state is restored as well: the next insert replaces the oldest entry.
+    d.insert(6, 60);
+    CHECK_FALSE(d.contains(2));
+    CHECK(d.contains(3));
+
+    // Images are loaded as is, e.g. from a memory-mapped file.
+    std::vector<std::byte> image(std::filesystem::file_size(path));
+    std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(image.data()), static_cast<std::streamsize>(image.size()));
+
+    Cache e;
+    REQUIRE(e.load(std::span<const std::byte>{image}));
+    CHECK_EQ(e.find(5), 50);
+
+    // Snapshots of other cache types, truncated or corrupted images are rejected, leaving the cache unchanged.
+    mc::memo_cache<int, int, 8> other;
+    CHECK_FALSE(other.load(path));
+    CHECK_FALSE(e.load(std::span<const std::byte>{image}.first(image.size() - 1)));
+    image[0] = std::byte{'M'};
+    CHECK_FALSE(e.load(std::span<const std::byte>{image}));
+    CHECK_FALSE(e.load(path.string() + ".missing"));
+    CHECK_EQ(e.find(5), 50);
+
+    std::filesystem::remove(path);
+
+    // So are images with out of bounds or inconsistent state, even if they have the right size and header.
+    const auto check_corrupted = [&path](auto&& f, std::size_t eviction_size) {
+      for (int i = 0; i < 6; ++i) {
+        f.insert(i, i * 10);
+      }
+
+      REQUIRE(f.save(path));
+
+      std::vector<std::byte> bytes(std::filesystem::file_size(path));
+      std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+      auto g = f;
+      REQUIRE(g.load(std::span<const std::byte>{bytes}));
+
+      // The eviction state (cursors, hands and links).
+      auto broken = bytes;
+      std::ranges::fill(std::span{broken}.last(eviction_size), std::byte{0xFF});
+      CHECK_FALSE(g.load(std::span<const std::byte>{broken}));
+
+      // The slot buffer (occupancy).
+      broken = bytes;
+      std::ranges::fill(std::span{broken}.subspan(64, broken.size() - 64 - eviction_size), std::byte{0xFF});
+      CHECK_FALSE(g.load(std::span<const std::byte>{broken}));
+
+      CHECK_EQ(g.find(5), 50);
+    };
+
+    check_corrupted(mc::memo_cache<int, int, 4, mc::policy::fifo>{}, sizeof(mc::policy::fifo::state<4>));
+    check_corrupted(mc::memo_cache<int, int, 4, mc::policy::clock>{}, sizeof(mc::policy::clock::state<4>));
+    check_corrupted(mc::memo_cache<int, int, 4, mc::policy::sieve>{}, sizeof(mc::policy::sieve::state<4>));
+    check_corrupted(mc::memo_cache<int, int, 4, mc::policy::s3fifo>{}, sizeof(mc::policy::s3fifo::state<4>));
+    check_corrupted(mc::memo_cache<int, int, 4, mc::policy::lru>{}, sizeof(mc::policy::lru::state<4>));
+
+    // A well-formed recency list that disagrees with the occupancy of the slots.
+    {
+      mc::memo_cache<int, int, 4, mc::policy::lru> full;
+      mc::memo_cache<int, int, 4, mc::policy::lru> half;
+      for (int i = 0; i < 4; ++i) {
+        full.insert(i, i);
+      }
+
+      half.insert(1, 1);
+
+      REQUIRE(full.save(path));
+      std::vector<std::byte> bytes(std::filesystem::file_size(path));
+      std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+      REQUIRE(half.save(path));
+      std::vector<std::byte> other_bytes(bytes.size());
+      std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(other_bytes.data()), static_cast<std::streamsize>(other_bytes.size()));
+
+      const auto eviction_size = sizeof(mc::policy::lru::state<4>);
+      std::ranges::copy(std::span{other_bytes}.last(eviction_size), std::span{bytes}.last(eviction_size).begin());
+
+      CHECK_FALSE(full.load(std::span<const std::byte>{bytes}));
+      CHECK_EQ(full.find(3), 3);
+    }
+
+    // Slots of the aligned layout out of bounds (padding), or of a later generation (occupied again after a `clear`).
+    const auto tamper = [&path]<typename Cache>(std::type_identity<Cache>, std::size_t slot, std::uint32_t generation, int key) {
+      // NOTE: 16-byte slots (key, value, generation and live bits), four per 64-byte bucket, then the buffer generation.
+      constexpr std::size_t SLOTS = 64, SLOT_SIZE = 16, GENERATION = 8;
+
+      Cache a;
+      for (int i = 0; i < 6; ++i) {
+        a.insert(i, i);
+      }
+
+      REQUIRE(a.save(path));
+      std::vector<std::byte> bytes(std::filesystem::file_size(path));
+      std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+      std::uint64_t buffer_size{};
+      std::memcpy(&buffer_size, bytes.data() + 40, sizeof(buffer_size)); // From the header.
+      REQUIRE_EQ(buffer_size, 2 * 64 + 64);
+
+      std::memcpy(bytes.data() + SLOTS + slot * SLOT_SIZE, &key, sizeof(key));
+      std::memcpy(bytes.data() + SLOTS + slot * SLOT_SIZE + GENERATION, &generation, sizeof(generation));
+      return bytes;
+    };
+
+    using aligned_lru  = mc::memo_cache<int, int, 6, mc::layout::aligned, mc::policy::lru>;
+    using aligned_fifo = mc::memo_cache<int, int, 6, mc::layout::aligned, mc::policy::fifo>;
+
+    {
+      aligned_fifo b;
+      REQUIRE(b.load(std::span<const std::byte>{tamper(std::type_identity<aligned_fifo>{}, 2, 1, 55)})); // Checks the offsets.
+      CHECK(b.contains(55));
+
+      aligned_lru d;
+      CHECK_FALSE(d.load(std::span<const std::byte>{tamper(std::type_identity<aligned_lru>{}, 7, 1, 99)}));
+      CHECK_FALSE(d.contains(99));
+
+      aligned_fifo e;
+      CHECK_FALSE(e.load(std::span<const std::byte>{tamper(std::type_identity<aligned_fifo>{}, 2, 2, 55)}));
+      e.clear();
+      CHECK_FALSE(e.contains(55));
+    }
+
+    std::filesystem::remove(path);
+
+    // Other types are serialized entry by entry.
+    mc::memo_cache<std::string, int, 4> s;
+    s.insert("a", 1);
+    s.insert("b", 2);
+
+    mc::memo_cache<std::string, int, 4> t;
+    s.for_each([&t](const std::string& k, const int& v) { t.insert(k, v); });
+
+    CHECK_EQ(t.find("a"), 1);
+    CHECK_EQ(t.find("b"), 2);
+  }
+
+  TEST_CASE("Constant evaluation")
+  {
+    static_assert(compile_time_fibonacci(90) == 2'880'067'194'370'816'120);
+    static_assert(compile_time_fibonacci<mc::layout::aos, mc::policy::lru>(90) == 2'880'067'194'370'816'120);
+
+    static_assert(compile_time_api());
+    static_assert(compile_time_api<mc::layout::aos>());
+    static_assert(compile_time_api<mc::layout::aligned>());
+    static_assert(compile_time_api<mc::policy::sieve>());
+
+    // Constant evaluation uses the scalar key scan; check that it agrees at runtime.
+    mc::memo_cache<int, std::uint64_t, 128> cache;
+    CHECK_EQ(fibonacci(cache, 90), compile_time_fibonacci(90));
+  }
+
+  TEST_CASE("Static type properties")
+  {
+    using Cache = mc::memo_cache<std::string, std::string, 8>;
+
+    // The cache is semiregular:
+    static_assert(std::is_constructible_v<Cache>);
+    static_assert(std::is_default_constructible_v<Cache>);
+    static_assert(std::is_copy_assignable_v<Cache>);
+    static_assert(std::is_copy_constructible_v<Cache>);
+    static_assert(std::is_move_assignable_v<Cache>);
+    static_assert(std::is_move_constructible_v<Cache>);
+  }
+
+} // TEST_SUITE
+
+TEST_SUITE("indexed_memo_cache")
+{
+
+  TEST_CASE("Cache size")
+  {
+    mc::indexed_memo_cache<std::string, int, 4096> c;
+
+    CHECK_EQ(c.size(), 4096);
+  }
+
+  TEST_CASE("find, insert, contains and clear")
+  {
+    mc::indexed_memo_cache<std::string, int, 3> c;
+
+    CHECK_FALSE(c.find("hello").has_value());
+    CHECK_FALSE(c.contains("hello"));
+
+    c.insert("hello", 42);
+
+    REQUIRE(c.find("hello").has_value());
+    CHECK_EQ(c.find("hello").value(), 42);
+    CHECK(c.contains("hello"));
+
+    c.insert("hello", 17); // Overwrite.
+
+    CHECK_EQ(c.find("hello").value(), 17);
+
+    c.clear();
+
+    CHECK_FALSE(c.contains("hello"));
+  }
+
+  TEST_CASE("find_or_insert_with")
+  {
+    mc::indexed_memo_cache<int, std::string, 16> c;
+
+    CHECK_EQ(c.find_or_insert_with(42, [](int) { return "The Answer"; }).get(), "The Answer");
+    CHECK_EQ(c.find_or_insert_with(42, [](int) {
+                 CHECK(false);
+                 return "Not used";
+               }).get(),
+             "The Answer");
+  }
+
+  TEST_CASE("FIFO retention")
+  {
+    // A poor hash function, forcing long probe sequences (and many shifts on deletion).
+    struct poor_hash {
+      std::size_t operator()(int k) const noexcept { return static_cast<std::size_t>(k % 5); }
+    };
+
+    const auto check_retention = [](auto& c, int universe) {
+      std::deque<int>              fifo;
+      std::unordered_map<int, int> model;
+
+      std::mt19937                       generator{1234}; // NOLINT: Deterministic.
+      std::uniform_int_distribution<int> distribution{0, universe};
+
+      for (int n = 0; n < 20'000; ++n) {
+        const auto k = distribution(generator);
+
+        if (const auto found = c.find(k); found) {
+          REQUIRE(model.contains(k));
+          CHECK_EQ(found->get(), model.at(k));
+          continue;
+        }
+
+        REQUIRE_FALSE(model.contains(k));
+
+        if (fifo.size() == c.size()) {
+          model.erase(fifo.front());
+          fifo.pop_front();
+        }
+
+        c.insert(k, n);
+        fifo.push_back(k);
+        model[k] = n;
+      }
+
+      for (const auto& [k, v] : model) {
+        REQUIRE(c.contains(k));
+        CHECK_EQ(c.find(k).value(), v);
+      }
+    };
+
+    auto c1 = std::make_unique<mc::indexed_memo_cache<int, int, 4096>>();
+    check_retention(*c1, 8192);
+
+    auto c2 = std::make_unique<mc::indexed_memo_cache<int, int, 100, poor_hash>>();
+    check_retention(*c2, 300);
+
+    auto c3 = std::make_unique<mc::indexed_memo_cache<int, int, 5>>();
+    check_retention(*c3, 10);
+  }
+
+} // TEST_SUITE
+
+TEST_SUITE("dynamic_memo_cache")
+{
+
+  TEST_CASE("Cache size")
+  {
+    mc::dynamic_memo_cache<std::string, int> c{1000};
+
+    CHECK_EQ(c.size(), 1000);
+    CHECK_EQ((mc::dynamic_memo_cache<int, int>{0}.size()), 1);
+  }
+
+  TEST_CASE("find, insert, contains and clear")
+  {
+    const auto check_cache = [](auto make_key) {
+      mc::dynamic_memo_cache<decltype(make_key(0)), int> c{3};
+
+      CHECK_FALSE(c.find(make_key(1)).has_value());
+
+      c.insert(make_key(1), 17);
+      c.insert(make_key(2), 19);
+      c.insert(make_key(3), 23);
+
+      CHECK_EQ(c.find(make_key(1)).value(), 17);
+
+      c.insert(make_key(1), 29); // Overwrite.
+
+      CHECK_EQ(*c.find_ptr(make_key(1)), 29);
+
+      c.insert(make_key(4), 31); // Evicts the oldest key.
+
+      CHECK_FALSE(c.contains(make_key(1)));
+      CHECK_EQ(c.find_or_insert_with(make_key(2), [](const auto&) { return 0; }), 19);
+      CHECK_EQ(c.find_or_insert_with(make_key(5), [](const auto&) { return 37; }), 37);
+      CHECK_FALSE(c.contains(make_key(2)));
+
+      c.clear();
+
+      CHECK_FALSE(c.contains(make_key(4)));
+      CHECK_FALSE(c.contains(make_key(5)));
+    };
+
+    check_cache([](int i) { return i; });
+    check_cache([](int i) { return std::to_string(i); });
+  }
+
+  TEST_CASE("Scannable keys over multiple scan blocks")
+  {
+    mc::dynamic_memo_cache<std::uint16_t, int> c{200};
+
+    for (int i = 0; i < 300; ++i) {
+      c.insert(static_cast<std::uint16_t>(i), i);
+    }
+
+    CHECK_FALSE(c.contains(99));
+    CHECK_EQ(c.find(100).value(), 100);
+    CHECK_EQ(c.find(299).value(), 299);
+  }
+
+  TEST_CASE("Memory resource")
+  {
+    counting_resource resource;
+
+    mc::dynamic_memo_cache<int, int> c{512, &resource};
+
+    CHECK_EQ(c.get_allocator().resource(), &resource);
+
+    const auto allocations = resource.allocations;
+
+    for (int i = 0; i < 2000; ++i) {
+      c.insert(i, i);
+    }
+
+    c.clear();
+
+    // Storage is never reallocated.
+    CHECK_EQ(resource.allocations, allocations);
+  }
+
+} // TEST_SUITE
+
+TEST_SUITE("concurrent_memo_cache")
+{
+
+  TEST_CASE("Cache size")
+  {
+    mc::concurrent_memo_cache<std::string, int, 64, 8> c;
+
+    CHECK_EQ(c.size(), 64);
+  }
+
+  TEST_CASE("find, insert, contains and clear")
+  {
+    mc::concurrent_memo_cache<std::string, int, 8, 4> c;
+
+    CHECK_FALSE(c.find("hello").has_value());
+    CHECK_FALSE(c.contains("hello"));
+
+    c.insert("hello", 42);
+
+    CHECK_EQ(c.find("hello"), 42);
+    CHECK(c.contains("hello"));
+
+    c.insert("hello", 17); // Overwrite.
+
+    CHECK_EQ(c.find("hello"), 17);
+
+    CHECK_EQ(c.find_or_insert_with("hi", [](auto&) { return 19; }), 19);
+    CHECK_EQ(c.find_or_insert_with("hi", [](auto&) {
+               CHECK(false);
+               return 23;
+             }),
+             19);
+
+    c.clear();
+
+    CHECK_FALSE(c.contains("hello"));
+    CHECK_FALSE(c.contains("hi"));
+  }
+
+  TEST_CASE("Concurrent access")
+  {
+    const auto hammer = [](auto& c) {
+      std::vector<std::thread> threads;
+
+      for (unsigned t = 0; t < 8; ++t) {
+        threads.emplace_back([&c, t] {
+          std::mt19937                       generator{t};
+          std::uniform_int_distribution<int> distribution{0, 500};
+
+          for (int n = 0; n < 20'000; ++n) {
+            const auto k = distribution(generator);
+
+            if (n % 2 == 0) {
+              CHECK_EQ(c.find_or_insert_with(k, [](int i) { return 2 * i; }), 2 * k);
+            } else if (const auto found = c.find(k); found) {
+              CHECK_EQ(*found, 2 * k);
+            }
+          }
+        });
+      }
+
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    };
+
+    auto c1 = std::make_unique<mc::concurrent_memo_cache<int, int, 256, 16>>();
+    hammer(*c1);
+
+    auto c2 = std::make_unique<mc::concurrent_memo_cache<int, int, 256, 4, mc::lock::shared>>();
+    hammer(*c2);
+
+    auto c3 = std::make_unique<mc::concurrent_memo_cache<int, int, 256, 4, mc::policy::lru, mc::lock::shared>>();
+    hammer(*c3);
+
+    auto c4 = std::make_unique<mc::concurrent_memo_cache<int, int, 256, 4, mc::admission::tinylfu, mc::lock::shared>>();
+    hammer(*c4);
+
+    auto c5 = std::make_unique<mc::concurrent_memo_cache<int, int, 256, 4, mc::probe::recent, mc::lock::shared>>();
+    hammer(*c5);
+  }
+
+  TEST_CASE("Single-flight find_or_insert_with")
+  {
+    using namespace std::chrono_literals;
+
+    mc::concurrent_memo_cache<int, int, 16, 4> c;
+
+    std::atomic<int> computations{0};
+
+    const auto run_concurrently = [](auto f) {
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 8; ++t) {
+        threads.emplace_back(f);
+      }
+
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    };
+
+    // Concurrent misses on the same key share a single computation.
+    run_concurrently([&] {
+      CHECK_EQ(c.find_or_insert_with(42, [&](int k) {
+                 ++computations;
+                 std::this_thread::sleep_for(100ms);
+                 return 2 * k;
+               }),
+               84);
+    });
+
+    CHECK_EQ(computations.load(), 1);
+
+    // Exceptions are shared with the waiters too, and nothing gets inserted.
+    std::atomic<int> failures{0};
+
+    run_concurrently([&] {
+      try {
+        (void)c.find_or_insert_with(17, [&](int) -> int {
+          ++computations;
+          std::this_thread::sleep_for(100ms);
+          throw std::runtime_error("Computation failed");
+        });
+      } catch (const std::runtime_error&) {
+        ++failures;
+      }
+    });
+
+    CHECK_EQ(computations.load(), 2);
+    CHECK_EQ(failures.load(), 8);
+    CHECK_FALSE(c.contains(17));
+
+    // A failing insert does not leave the waiters behind: they get the value, and only the computing thread the error.
+    mc::concurrent_memo_cache<int, int, 1, 1, mc::stats::counters> d;
+    d.insert(1, 1);
+    d.set_eviction_hook([](const int&, const int&) { throw std::runtime_error("Hook failed"); });
+
+    std::atomic<int> values{0};
+    failures = 0;
+
+    run_concurrently([&] {
+      try {
+        CHECK_EQ(d.find_or_insert_with(42, [&](int k) {
+                   std::this_thread::sleep_for(100ms);
+                   return 2 * k;
+                 }),
+                 84);
+        ++values;
+      } catch (const std::runtime_error&) {
+        ++failures;
+      }
+    });
+
+    CHECK_GE(failures.load(), 1);
+    CHECK_EQ(values.load() + failures.load(), 8);
+  }
+
+  TEST_CASE("Statistics")
+  {
+    mc::concurrent_memo_cache<int, int, 64, 4, mc::stats::counters, mc::lock::shared> c;
+
+    std::atomic<int> evicted{0};
+    c.set_eviction_hook([&evicted](const int&, const int&) { ++evicted; });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&c] {
+        for (int i = 0; i < 1'000; ++i) {
+          (void)c.find_or_insert_with(i % 100, [](int k) { return k; });
+          (void)c.find(i % 100);
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    const auto stats = c.statistics();
+
+    CHECK_GE(stats.hits + stats.misses, 8'000); // Misses are looked up again before inserting.
+    CHECK_GT(stats.evictions, 0);
+    CHECK_EQ(stats.evictions, static_cast<std::uint64_t>(evicted.load()));
+  }
+
+} // TEST_SUITE
+
+TEST_SUITE("tiered_memo_cache")
+{
+
+  TEST_CASE("Cache size")
+  {
+    mc::tiered_memo_cache<std::string, int, 8, 64, 8> c;
+
+    CHECK_EQ(c.size(), 64);
+    CHECK_EQ(c.local_size(), 8);
+  }
+
+  TEST_CASE("find, insert, contains and clear")
+  {
+    mc::tiered_memo_cache<std::string, int, 2, 8, 4> c;
+
+    CHECK_FALSE(c.find("hello").has_value());
+    CHECK_FALSE(c.contains("hello"));
+
+    c.insert("hello", 42);
+
+    CHECK_EQ(c.find("hello"), 42);
+    CHECK(c.contains("hello"));
+
+    CHECK_EQ(c.find_or_insert_with("hi", [](auto&) { return 19; }), 19);
+
+    // Entries evicted from the thread cache are still found in the shared cache (and promoted again).
+    c.insert("a", 1);
+    c.insert("b", 2);
+
+    CHECK_EQ(c.find_or_insert_with("hello", [](auto&) {
+               CHECK(false);
+               return 0;
+             }),
+             42);
+
+    c.clear();
+
+    CHECK_FALSE(c.contains("hello"));
+    CHECK_FALSE(c.contains("b"));
+  }
+
+  TEST_CASE("Caches sharing thread caches")
+  {
+    // More caches than thread caches per cache type: they take over each other's thread caches.
+    std::vector<std::unique_ptr<mc::tiered_memo_cache<int, int, 4, 16, 4>>> caches;
+    for (int i = 0; i < 6; ++i) {
+      caches.push_back(std::make_unique<mc::tiered_memo_cache<int, int, 4, 16, 4>>());
+    }
+
+    for (int round = 0; round < 2; ++round) {
+      for (int i = 0; i < 6; ++i) {
+        CHECK_EQ(caches[static_cast<std::size_t>(i)]->find_or_insert_with(17, [i](int) { return i; }), i);
+      }
+    }
+
+    // A new cache never sees the entries of a destroyed one.
+    caches.clear();
+    mc::tiered_memo_cache<int, int, 4, 16, 4> c;
+    CHECK_FALSE(c.contains(17));
+  }
+
+  TEST_CASE("Concurrent access")
+  {
+    mc::tiered_memo_cache<int, int, 16, 256, 8> c;
+
+    std::atomic<int> computations{};
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < 8; ++t) {
+      threads.emplace_back([&c, &computations, t] {
+        std::mt19937                       generator{t};
+        std::uniform_int_distribution<int> distribution{0, 100};
+
+        for (int n = 0; n < 20'000; ++n) {
+          const auto k = distribution(generator);
+
+          CHECK_EQ(c.find_or_insert_with(k, [&computations](int i) {
+                     ++computations;
+                     return 2 * i;
+                   }),
+                   2 * k);
+
+          if (t == 0 && n == 10'000) {
+            c.clear();
+          }
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // Every key was computed at least once (and again at most once per thread after the clear, or fewer).
+    CHECK_GE(computations.load(), 101);
+    CHECK_LE(computations.load(), 2 * 101 * 8);
+  }
+
+  TEST_CASE("Memoized function")
+  {
+    std::atomic<int> calls{};
+
+    const auto square = mc::memoize<64, mc::storage::tiered<8, 4>>([&calls](int x) {
+      ++calls;
+      return x * x;
+    });
+
+    const auto copy = square;
+
+    CHECK_EQ(square(7), 49);
+    CHECK_EQ(copy(7), 49); // Shared.
+    CHECK_EQ(calls.load(), 1);
+  }
+
+} // TEST_SUITE
+
+TEST_SUITE("async_memo_cache")
+{
+
+  TEST_CASE("Cache size")
+  {
+    mc::async_memo_cache<int, int, 16> c;
+
+    CHECK_EQ(c.size(), 16);
+  }
+
+  TEST_CASE("find_or_insert_async")
+  {
+    mc::async_memo_cache<int, int, 16> c;
+    io_queue io;
+
+    int reads = 0;
+    std::vector<int> results;
+
+    const auto lookup = [&](int key) -> spawned {
+      results.push_back(co_await c.find_or_insert_async(key, [&](int k) {
+        ++reads;
+        return io.read(k);
+      }));
+    };
+
+    // Concurrent lookups of the same key share a single read.
+    lookup(17);
+    lookup(17);
+    lookup(23);
+
+    CHECK_EQ(c.pending(), 2);
+    CHECK(results.empty());
+    CHECK_FALSE(c.contains(17));
+
+    io.complete_all([](int k) { return 2 * k; });
+
+    CHECK_EQ(reads, 2);
+    CHECK_EQ(c.pending(), 0);
+    CHECK_EQ(results, std::vector<int>{34, 34, 46});
+    CHECK_EQ(c.find(17), 34);
+
+    // Hits complete right away.
+    lookup(17);
+
+    CHECK_EQ(reads, 2);
+    CHECK_EQ(results.back(), 34);
+  }
+
+  TEST_CASE("Synchronous completion and exceptions")
+  {
+    mc::async_memo_cache<int, int, 16> c;
+
+    // An awaitable that never suspends.
+    const auto ready = [](int k) {
+      struct ready_awaitable {
+        int value;
+        bool await_ready() const noexcept { return true; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        int await_resume() const noexcept { return value; }
+      };
+      return ready_awaitable{k + 1};
+    };
+
+    int result = 0;
+    [&]() -> spawned { result = co_await c.find_or_insert_async(41, ready); }();
+
+    CHECK_EQ(result, 42);
+    CHECK(c.contains(41));
+
+    io_queue io;
+    int failures = 0;
+
+    const auto failing = [&](int key) -> spawned {
+      try {
+        co_await c.find_or_insert_async(key, [&io](int k) { return io.read(k); });
+      } catch (const std::runtime_error&) {
+        ++failures;
+      }
+    };
+
+    failing(7);
+    failing(7);
+
+    io.complete_all([](int) { return -1; });
+
+    // Both awaiters see the exception, and nothing is cached.
+    CHECK_EQ(failures, 2);
+    CHECK_FALSE(c.contains(7));
+    CHECK_EQ(c.pending(), 0);
+  }
+
+} // TEST_SUITE
+
+TEST_SUITE("seqlock_memo_cache")
+{
+
+  TEST_CASE("find, insert, contains and clear")
+  {
+    mc::seqlock_memo_cache<int, float, 3> c;
+
+    CHECK_EQ(c.size(), 3);
+    CHECK_FALSE(c.find(17).has_value());
+    CHECK_FALSE(c.contains(17));
+
+    c.insert(17, 42.0f);
+
+    CHECK_EQ(c.find(17), 42.0f);
+    CHECK(c.contains(17));
+
+    c.insert(17, 19.0f); // Overwrite.
+
+    CHECK_EQ(c.find(17), 19.0f);
+    CHECK_EQ(c.find_or_insert_with(23, [](int) { return 29.0f; }), 29.0f);
+    CHECK_EQ(c.find_or_insert_with(23, [](int) {
+               CHECK(false);
+               return 31.0f;
+             }),
+             29.0f);
+
+    c.insert(1, 1.0f);
+    c.insert(2, 2.0f); // Evicts the oldest key.
+
+    CHECK_FALSE(c.contains(17));
+    CHECK(c.contains(23));
+
+    c.clear();
+
+    CHECK_FALSE(c.contains(23));
+    CHECK_FALSE(c.contains(1));
+  }
+
+  TEST_CASE("Concurrent readers")
+  {
+    // Multi-word keys and values, to detect torn reads.
+    using Key = std::array<std::uint64_t, 2>;
+
+    struct Val {
+      std::uint64_t a;
+      std::uint64_t b;
+      std::uint64_t c;
+    };
+
+    mc::seqlock_memo_cache<Key, Val, 16> c;
+
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < 4; ++t) {
+      readers.emplace_back([&c, &done, t] {
+        std::mt19937                                 generator{t};
+        std::uniform_int_distribution<std::uint64_t> distribution{0, 32};
+
+        while (!done.load()) {
+          const auto k = distribution(generator);
+          if (const auto found = c.find(Key{k, ~k}); found) {
+            CHECK((found->a == k && found->b == 2 * k && found->c == 3 * k));
+          }
+        }
+      });
+    }
+
+    std::mt19937                                 generator{1234}; // NOLINT: Deterministic.
+    std::uniform_int_distribution<std::uint64_t> distribution{0, 32};
+
+    for (int n = 0; n < 100'000; ++n) {
+      const auto k = distribution(generator);
+      c.insert(Key{k, ~k}, Val{k, 2 * k, 3 * k});
+    }
+
+    done = true;
+
+    for (auto& reader : readers) {
+      reader.join();
+    }
+  }
+
+} // TEST_SUITE
+
+#if defined(MC_SHARED_MEMORY)
+
+TEST_SUITE("shared_memory_memo_cache")
+{
+
+  /// Run `f` in a child process. Returns the pid of the child.
+  template<typename F>
+  ::pid_t spawn(F f) {
+    const auto pid = ::fork();
+    if (pid == 0) {
+      ::_exit(f() ? 0 : 1);
+    }
+
+    return pid;
+  }
+
+  /// Wait for the child process `pid` to exit. Returns `true` if it succeeded.
+  bool succeeded(::pid_t pid) {
+    int status{};
+    return pid > 0 && ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+  TEST_CASE("find, insert, contains and clear")
+  {
+    using Cache = mc::shared_memory_memo_cache<int, float, 3>;
+
+    const auto name = "/mc-test-" + std::to_string(::getpid());
+    Cache::remove(name);
+
+    auto a = Cache::open(name);
+    auto b = Cache::open(name);
+    REQUIRE(a.has_value());
+    REQUIRE(b.has_value());
+
+    CHECK_EQ(a->size(), 3);
+    CHECK_FALSE(b->contains(17));
+
+    // Both mappings share the cache.
+    a->insert(17, 42.0f);
+    CHECK_EQ(b->find(17), 42.0f);
+
+    b->insert(17, 19.0f); // Overwrite.
+    CHECK_EQ(a->find(17), 19.0f);
+    CHECK_EQ(b->find_or_insert_with(23, [](int) { return 29.0f; }), 29.0f);
+    CHECK_EQ(a->find_or_insert_with(23, [](int) {
+               CHECK(false);
+               return 31.0f;
+             }),
+             29.0f);
+
+    a->insert(1, 1.0f);
+    b->insert(2, 2.0f); // Evicts the oldest key.
+
+    CHECK_FALSE(a->contains(17));
+    CHECK(a->contains(23));
+
+    b->clear();
+    CHECK_FALSE(a->contains(23));
+
+    // Other cache types are rejected.
+    CHECK_FALSE(mc::shared_memory_memo_cache<int, double, 3>::open(name).has_value());
+    CHECK_FALSE(mc::shared_memory_memo_cache<int, float, 4>::open(name).has_value());
+
+    CHECK(Cache::remove(name));
+    CHECK_FALSE(Cache::remove(name));
+
+    // Mappings outlive the removal, and handles move.
+    a->insert(5, 5.0f);
+    auto c = std::move(*b);
+    CHECK_EQ(c.find(5), 5.0f);
+  }
+
+  TEST_CASE("Processes")
+  {
+    using Key = std::array<std::uint64_t, 2>;
+
+    struct Val {
+      std::uint64_t a;
+      std::uint64_t b;
+      std::uint64_t c;
+    };
+
+    using Cache = mc::shared_memory_memo_cache<Key, Val, 16>;
+
+    const auto name = "/mc-test-" + std::to_string(::getpid());
+    Cache::remove(name);
+
+    auto cache = Cache::open(name);
+    REQUIRE(cache.has_value());
+
+    const auto write = [&name](std::uint64_t seed) {
+      auto c = Cache::open(name);
+      if (!c) {
+        return false;
+      }
+
+      std::mt19937_64 generator{seed};
+      std::uniform_int_distribution<std::uint64_t> distribution{0, 32};
+
+      bool consistent = true;
+      for (int n = 0; n < 20'000; ++n) {
+        const auto k = distribution(generator);
+        if (const auto found = c->find(Key{k, ~k}); found) {
+          consistent = consistent && (found->a == k && found->b == 2 * k && found->c == 3 * k);
+        }
+
+        c->insert(Key{k, ~k}, Val{k, 2 * k, 3 * k});
+      }
+
+      return consistent;
+    };
+
+    // A writing child process races the writes and torn-read checks of this one.
+    const auto child = spawn([&] { return write(2); });
+    CHECK(write(1));
+    CHECK(succeeded(child));
+
+    // Values inserted by a child process are found here.
+    CHECK(succeeded(spawn([&name] {
+      auto c = Cache::open(name);
+      return c && (c->clear(), c->insert(Key{99, 0}, Val{1, 2, 3}), true);
+    })));
+
+    CHECK_EQ(cache->find(Key{99, 0}).value().c, 3);
+    CHECK_EQ(cache->find_or_insert_with(Key{99, 0}, [](const Key&) { return Val{}; }).b, 2);
+
+    Cache::remove(name);
+  }
+
+  /// Map the shared memory object `name` in a child process, run `f` on its bytes, and exit without any cleanup (as if
+  /// the child died there). Returns `true` if the child got that far.
+  template<typename F>
+  bool die_after(const std::string& name, std::size_t size, F f) {
+    return succeeded(spawn([&] {
+      const int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+      void* mapping = (fd >= 0) ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+      if (mapping == MAP_FAILED) {
+        return false;
+      }
+
+      f(static_cast<std::byte*>(mapping));
+      return true;
+    }));
+  }
+
+  // NOTE: The segment starts with the initialization word and lock, the layout header (64 bytes) and the cursor; every
+  //       slot of `int` keys and values with its writer lock, the sequence number, the occupied flag (padded) and one word.
+  constexpr std::size_t INIT_LOCK = 8;
+  constexpr std::size_t SLOTS     = INIT_LOCK + sizeof(::pthread_mutex_t) + 64 + 8;
+  constexpr std::size_t SLOT_SIZE = sizeof(::pthread_mutex_t) + 8 + 8;
+  constexpr std::size_t SEQUENCE  = sizeof(::pthread_mutex_t);
+
+  TEST_CASE("Initialization by a process that died")
+  {
+    using Cache = mc::shared_memory_memo_cache<int, int, 4>;
+
+    const auto name = "/mc-test-" + std::to_string(::getpid());
+    Cache::remove(name);
+
+    REQUIRE(Cache::open(name).has_value());
+
+    // A process that dies while initializing the segment (holding its lock, before marking it ready).
+    REQUIRE(die_after(name, SLOTS, [](std::byte* segment) {
+      static_cast<void>(::pthread_mutex_lock(reinterpret_cast<::pthread_mutex_t*>(segment + INIT_LOCK)));
+      reinterpret_cast<std::atomic<std::uint64_t>*>(segment)->store(2);
+    }));
+
+    // The next process to open the segment takes over.
+    auto c = Cache::open(name);
+    REQUIRE(c.has_value());
+
+    c->insert(1, 10);
+    CHECK_EQ(c->find(1), 10);
+
+    Cache::remove(name);
+  }
+
+  TEST_CASE("Writes by a process that died")
+  {
+    using Cache = mc::shared_memory_memo_cache<int, int, 4>;
+
+    const auto name = "/mc-test-" + std::to_string(::getpid());
+    Cache::remove(name);
+
+    auto c = Cache::open(name);
+    REQUIRE(c.has_value());
+
+    // A writer that dies mid-write, holding the lock of slot 0 (the next one to be written).
+    const auto die_writing_slot_0 = [&name] {
+      return die_after(name, SLOTS + SLOT_SIZE, [](std::byte* segment) {
+        static_cast<void>(::pthread_mutex_lock(reinterpret_cast<::pthread_mutex_t*>(segment + SLOTS)));
+        reinterpret_cast<std::atomic<std::uint32_t>*>(segment + SLOTS + SEQUENCE)->fetch_add(1);
+      });
+    };
+
+    // The next writer recovers the slot.
+    REQUIRE(die_writing_slot_0());
+
+    for (int i = 1; i <= 4; ++i) {
+      c->insert(i, i * 10);
+    }
+
+    for (int i = 1; i <= 4; ++i) {
+      CHECK_EQ(c->find(i), i * 10);
+    }
+
+    // So does the next reader, dropping the (possibly torn) entry.
+    REQUIRE(die_writing_slot_0());
+
+    CHECK_FALSE(c->find(1).has_value());
+    CHECK_EQ(c->find(2), 20);
+
+    c->insert(5, 50);
+    CHECK_EQ(c->find(5), 50);
+
+    Cache::remove(name);
+  }
+
+} // TEST_SUITE
+
+#endif
+
+namespace {
+
+int calls = 0;
+
+float scaled(int input, float scale) {
+  ++calls;
+  return static_cast<float>(input) * scale;
+}
+
+} // namespace
+
+TEST_SUITE("memoize")
+{
+
+  TEST_CASE("Unary functions")
+  {
+    int n = 0;
+
+    auto square = mc::memoize<4>([&n](int i) {
+      ++n;
+      return i * i;
+    });
+
+    CHECK_EQ(square(3), 9);
+    CHECK_EQ(square(3), 9);
+    CHECK_EQ(square(4), 16);
+    CHECK_EQ(n, 2);
+
+    square.clear();
+
+    CHECK_EQ(square(3), 9);
+    CHECK_EQ(n, 3);
+
+    // By-value (and rvalue reference) arguments are cached as passed, even if `f` moves from them.
+    const auto len = mc::memoize<16>([](std::string s) { return std::string{std::move(s)}.size(); });
+
+    CHECK_EQ(len(std::string(40, 'x')), 40);
+    CHECK_EQ(len(""), 0);
+    CHECK_EQ(len(std::string(40, 'x')), 40);
+
+    const auto sink = mc::memoize<16>([](std::string&& s) { return std::string{std::move(s)}.size(); });
+
+    CHECK_EQ(sink(std::string(40, 'x')), 40);
+    CHECK_EQ(sink(""), 0);
+  }
+
+  TEST_CASE("Functions with multiple arguments")
+  {
+    calls = 0;
+
+    const auto f = mc::memoize<4, mc::policy::lru>(&scaled);
+
+    CHECK_EQ(f(2, 1.5f), 3.0f);
+    CHECK_EQ(f(2, 1.5f), 3.0f);
+    CHECK_EQ(f(2, 2.5f), 5.0f);
+    CHECK_EQ(f(3, 1.5f), 4.5f);
+    CHECK_EQ(calls, 3);
+
+    // Arguments are compared in place, and only copied on a miss.
+    int n = 0;
+
+    auto g = mc::memoize<4>([&n](const tracked_value& v, const std::string& s) {
+      ++n;
+      return static_cast<std::size_t>(v.value) + s.size();
+    });
+
+    const tracked_value v{17};
+
+    tracked_value::copies = 0;
+
+    CHECK_EQ(g(v, "hello"), 22);
+    CHECK_EQ(tracked_value::copies, 1);
+    CHECK_EQ(g(v, "hello"), 22);
+    CHECK_EQ(tracked_value::copies, 1);
+    CHECK_EQ(n, 1);
+  }
+
+  TEST_CASE("Explicit signature")
+  {
+    const auto generic = [](auto a, auto b) { return a * b; };
+
+    mc::memoized<decltype(generic), long(long, long), 4> f{generic};
+
+    CHECK_EQ(f(6, 7), 42);
+  }
+
+  TEST_CASE("Shared storage")
+  {
+    std::atomic<int> n{0};
+
+    const auto f = mc::memoize<64, mc::storage::shared<4>>([&n](int a, int b) {
+      ++n;
+      return a * b;
+    });
+
+    // Copies share the cache.
+    const auto g = f;
+
+    CHECK_EQ(f(6, 7), 42);
+    CHECK_EQ(g(6, 7), 42);
+    CHECK_EQ(n.load(), 1);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&f, t] {
+        for (int i = 0; i < 1'000; ++i) {
+          CHECK_EQ(f(i % 16, t), (i % 16) * t);
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
   }
 
 } // TEST_SUITE
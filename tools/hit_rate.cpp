@@ -0,0 +1,318 @@
+#include <memo_cache.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Hit rate simulator and capacity advisor: replays a recorded key trace through `memo_cache`, with every eviction policy
+// at every capacity (in powers of two), and estimates the LRU miss ratio curve for any capacity in a single pass.
+//
+// The trace holds one key per line, in access order (e.g. extracted from request logs). The keys are interned as dense
+// integers, so that the replay does not depend on the key type; the hit rates do not either.
+//
+// Usage:
+//
+//   hit_rate [--target <hit rate>] [--sample-rate <rate>] [<trace file>]
+//
+// reads the trace from standard input if no file is given. `--target` (default 0.9) is the hit rate to advise a capacity
+// and policy for, and `--sample-rate` (default 1, i.e. exact) the fraction of keys sampled for the miss ratio curve. A
+// sampled curve takes a fraction of the time and memory on long traces, but does not resolve capacities below about
+// `1 / rate` entries (the simulated hit rates are always exact).
+//
+// Build:
+//
+//   clang++-18 -std=c++20 -O3 -DNDEBUG -I../include ../tools/hit_rate.cpp -o hit_rate
+
+namespace {
+
+using trace_key = std::uint32_t;
+
+constexpr std::array<std::size_t, 9> CAPACITIES = {4, 8, 16, 32, 64, 128, 256, 512, 1024};
+
+constexpr std::size_t LOOKUP_COST_LIMIT = 128; // The capacity up to which lookups stay cheap (see performance notes).
+
+using hit_rates = std::array<double, CAPACITIES.size()>;
+
+/// Replay `trace` through a cache of `Size` entries (with `Options`). Returns the hit rate.
+template<std::size_t Size, typename... Options>
+double replay(const std::vector<trace_key>& trace) {
+  // NOTE: On the heap, as the largest caches do not fit on (some) stacks.
+  auto cache = std::make_unique<mc::memo_cache<trace_key, std::uint32_t, Size, mc::stats::counters, Options...>>();
+
+  for (const auto key : trace) {
+    static_cast<void>(cache->find_or_insert_with(key, [](trace_key) { return 0u; }));
+  }
+
+  return cache->statistics().hit_ratio();
+}
+
+template<typename... Options>
+hit_rates replay_all(const std::vector<trace_key>& trace) {
+  return [&trace]<std::size_t... I>(std::index_sequence<I...>) {
+    return hit_rates{replay<CAPACITIES[I], Options...>(trace)...};
+  }(std::make_index_sequence<CAPACITIES.size()>{});
+}
+
+struct variant {
+  const char* name;
+  hit_rates (*replay)(const std::vector<trace_key>&);
+};
+
+// NOTE: `greedy_dual_size` is left out, as traces hold no entry sizes; with unit weights it evicts like `lru`.
+constexpr std::array<variant, 7> VARIANTS = {{
+  {"fifo", &replay_all<mc::policy::fifo>},
+  {"clock", &replay_all<mc::policy::clock>},
+  {"sieve", &replay_all<mc::policy::sieve>},
+  {"s3fifo", &replay_all<mc::policy::s3fifo>},
+  {"lru", &replay_all<mc::policy::lru>},
+  {"fifo+tinylfu", &replay_all<mc::policy::fifo, mc::admission::tinylfu>},
+  {"lru+tinylfu", &replay_all<mc::policy::lru, mc::admission::tinylfu>},
+}};
+
+/// Fenwick tree of counts, for prefix sums in logarithmic time.
+class fenwick_tree {
+  std::vector<std::int64_t> tree;
+
+public:
+  explicit fenwick_tree(std::size_t size) : tree(size + 1) {}
+
+  void add(std::size_t i, std::int64_t delta) {
+    for (++i; i < tree.size(); i += i & (~i + 1)) {
+      tree[i] += delta;
+    }
+  }
+
+  /// The sum of the counts in `[0, i)`.
+  [[nodiscard]] std::int64_t prefix_sum(std::size_t i) const {
+    std::int64_t sum{};
+    for (; i > 0; i -= i & (~i + 1)) {
+      sum += tree[i];
+    }
+    return sum;
+  }
+};
+
+/// Finalize a hash value (SplitMix64), so that sampling by its low bits is uniform.
+[[nodiscard]] std::uint64_t mix(std::uint64_t h) noexcept {
+  h += 0x9E37'79B9'7F4A'7C15ULL;
+  h = (h ^ (h >> 30)) * 0xBF58'476D'1CE4'E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D0'49BB'1331'11EBULL;
+  return h ^ (h >> 31);
+}
+
+/// LRU miss ratio curve, from the stack (reuse) distances of the accesses: an access hits in an LRU cache of capacity `c`
+/// exactly if fewer than `c` other keys were accessed since the previous access of its key.
+///
+/// Only the keys with a hash below `rate` are tracked (SHARDS), and their distances scaled by `1 / rate`: the sampled keys
+/// see about `rate` times as many distinct keys in between, so the curve keeps its shape at a fraction of the cost. As a
+/// few hot keys may take most accesses, the difference between the expected and actual number of sampled accesses is
+/// counted as hits at the smallest distance (SHARDS-adj).
+class miss_ratio_curve {
+  std::vector<std::uint64_t> histogram; // Of scaled distances (minus one); cold misses are not counted.
+  std::uint64_t sampled{};
+  double        expected{};             // The expected number of sampled accesses.
+
+public:
+  miss_ratio_curve(const std::vector<trace_key>& trace, double rate) {
+    const auto threshold = static_cast<std::uint64_t>(std::ldexp(rate, 32));
+
+    fenwick_tree last_accesses(trace.size()); // Holds a one at the time of the last access of every (sampled) key.
+    std::unordered_map<trace_key, std::size_t> last_access;
+
+    for (const auto key : trace) {
+      if ((mix(key) & 0xFFFF'FFFF) >= threshold) {
+        continue;
+      }
+
+      const auto now = static_cast<std::size_t>(sampled++);
+
+      if (const auto found = last_access.find(key); found != last_access.end()) {
+        const auto distance = last_accesses.prefix_sum(now) - last_accesses.prefix_sum(found->second);
+        const auto scaled   = static_cast<std::size_t>(std::llround(static_cast<double>(distance) / rate));
+
+        if (histogram.size() < scaled) {
+          histogram.resize(scaled);
+        }
+
+        ++histogram[scaled - 1];
+        last_accesses.add(found->second, -1);
+        found->second = now;
+      } else {
+        last_access.emplace(key, now);
+      }
+
+      last_accesses.add(now, 1);
+    }
+
+    expected = rate * static_cast<double>(trace.size());
+  }
+
+  /// The (estimated) hit ratio of an LRU cache with `capacity` entries, given its hits among the sampled accesses.
+  [[nodiscard]] double hit_ratio(std::uint64_t hits) const {
+    return std::clamp((static_cast<double>(hits) + expected - static_cast<double>(sampled)) / expected, 0.0, 1.0);
+  }
+
+  /// The (estimated) miss ratio of an LRU cache with `capacity` entries.
+  [[nodiscard]] double miss_ratio(std::size_t capacity) const {
+    if (sampled == 0) {
+      return 1.0;
+    }
+
+    std::uint64_t hits{};
+    for (std::size_t d = 0; d < std::min(capacity, histogram.size()); ++d) {
+      hits += histogram[d];
+    }
+
+    return 1.0 - hit_ratio(hits);
+  }
+
+  /// The smallest capacity at which the (estimated) LRU hit rate reaches `target`, if any.
+  [[nodiscard]] std::optional<std::size_t> capacity_for(double target) const {
+    std::uint64_t hits{};
+    for (std::size_t d = 0; d < histogram.size(); ++d) {
+      hits += histogram[d];
+      if (hit_ratio(hits) >= target) {
+        return d + 1;
+      }
+    }
+
+    return std::nullopt;
+  }
+};
+
+/// Read one key per line, interned as dense integers.
+std::vector<trace_key> read_trace(std::istream& in, std::size_t& distinct) {
+  std::unordered_map<std::string, trace_key> ids;
+  std::vector<trace_key> trace;
+
+  for (std::string line; std::getline(in, line);) {
+    trace.push_back(ids.try_emplace(std::move(line), static_cast<trace_key>(ids.size())).first->second);
+  }
+
+  distinct = ids.size();
+  return trace;
+}
+
+int usage() {
+  std::fputs("usage: hit_rate [--target <hit rate>] [--sample-rate <rate>] [<trace file>]\n", stderr);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  double      target = 0.9;
+  double      rate   = 1.0;
+  std::string path;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+
+    if ((arg == "--target" || arg == "--sample-rate") && i + 1 < argc) {
+      const std::string_view value = argv[++i];
+      if (std::from_chars(value.data(), value.data() + value.size(), arg == "--target" ? target : rate).ec != std::errc{}) {
+        return usage();
+      }
+    } else if (!arg.starts_with("--") && path.empty()) {
+      path = arg;
+    } else {
+      return usage();
+    }
+  }
+
+  if (!(target > 0 && target <= 1) || !(rate > 0 && rate <= 1)) {
+    return usage();
+  }
+
+  std::size_t distinct{};
+  std::vector<trace_key> trace;
+
+  if (path.empty()) {
+    trace = read_trace(std::cin, distinct);
+  } else if (std::ifstream in(path); in) {
+    trace = read_trace(in, distinct);
+  } else {
+    std::fprintf(stderr, "hit_rate: cannot read %s\n", path.c_str());
+    return 1;
+  }
+
+  if (trace.empty()) {
+    std::fputs("hit_rate: empty trace\n", stderr);
+    return 1;
+  }
+
+  std::printf("%zu accesses, %zu distinct keys (at most %.4f hits)\n\n", trace.size(), distinct,
+              1.0 - static_cast<double>(distinct) / static_cast<double>(trace.size()));
+
+  // Hit rates.
+  std::printf("%-8s", "capacity");
+  for (const auto& v : VARIANTS) {
+    std::printf(" %12s", v.name);
+  }
+  std::printf(" %12s\n", "lru (curve)");
+
+  std::array<hit_rates, VARIANTS.size()> results{};
+  for (std::size_t v = 0; v < VARIANTS.size(); ++v) {
+    results[v] = VARIANTS[v].replay(trace);
+  }
+
+  const miss_ratio_curve curve(trace, rate);
+
+  for (std::size_t c = 0; c < CAPACITIES.size(); ++c) {
+    std::printf("%-8zu", CAPACITIES[c]);
+    for (const auto& r : results) {
+      std::printf(" %12.4f", r[c]);
+    }
+    std::printf(" %12.4f\n", 1.0 - curve.miss_ratio(CAPACITIES[c]));
+  }
+
+  // Miss ratio curve, past the capacities of `memo_cache`.
+  std::printf("\nlru miss ratio curve (sample rate %g):\n", rate);
+  for (std::size_t c = 1; c <= std::max<std::size_t>(2 * distinct, 2); c *= 2) {
+    std::printf("%-8zu %12.4f\n", c, curve.miss_ratio(c));
+  }
+
+  // Advice: the smallest capacity reaching the target hit rate, and the best policy at that capacity.
+  std::printf("\n");
+  for (std::size_t c = 0; c < CAPACITIES.size(); ++c) {
+    std::size_t best = 0;
+    for (std::size_t v = 1; v < VARIANTS.size(); ++v) {
+      best = (results[v][c] > results[best][c]) ? v : best;
+    }
+
+    if (results[best][c] >= target) {
+      std::printf("advice: memo_cache<Key, Val, %zu> with %s reaches a hit rate of %.4f (target %g).\n", CAPACITIES[c],
+                  VARIANTS[best].name, results[best][c], target);
+
+      if (CAPACITIES[c] > LOOKUP_COST_LIMIT) {
+        std::printf("        Lookups scan all %zu slots; see the performance notes, or consider indexed_memo_cache.\n", CAPACITIES[c]);
+      }
+
+      return 0;
+    }
+  }
+
+  // NOTE: Past the simulated capacities, only the (estimated) LRU capacity is known; no cache type is recommended, as
+  //       the larger caches (`dynamic_memo_cache` and `indexed_memo_cache`) evict in FIFO order, and may need more.
+  if (const auto capacity = curve.capacity_for(target)) {
+    std::printf("advice: the target hit rate %g takes an lru capacity of about %zu entries (estimated, past the simulated capacities).\n",
+                target, *capacity);
+  } else {
+    std::printf("advice: the target hit rate %g is out of reach, as %zu of the %zu accesses are first accesses.\n", target, distinct,
+                trace.size());
+  }
+
+  return 0;
+}